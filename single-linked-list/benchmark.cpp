@@ -0,0 +1,522 @@
+// Измерения производительности и расхода памяти списка
+// Сборка: g++ -std=c++17 -O2 -pthread benchmark.cpp -o benchmark
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <map>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "single-linked-list.h"
+#include "skip-list-map.h"
+#include "split-ordered-map.h"
+#include "spsc-queue.h"
+
+namespace
+{
+    constexpr size_t kElementCount = 1000000;
+
+    // Простейший узел {значение, указатель} без дополнительных полей; выделяется через malloc
+    template <typename Type>
+    struct PlainNode
+    {
+        Type value;
+        PlainNode* next_node = nullptr;
+    };
+
+    // Байт на элемент при выделении простейших узлов через operator new
+    template <typename Type>
+    double PlainBytesPerElement()
+    {
+        const size_t before = mallinfo2().uordblks;
+        std::vector<PlainNode<Type>*> nodes(kElementCount);
+        const size_t vector_bytes = mallinfo2().uordblks - before;
+
+        for(auto& node : nodes)
+        {
+            node = new PlainNode<Type>();
+        }
+
+        const size_t used = mallinfo2().uordblks - before - vector_bytes;
+
+        for(auto* node : nodes)
+        {
+            delete node;
+        }
+
+        return static_cast<double>(used) / kElementCount;
+    }
+
+    // Байт на элемент для SingleLinkedList: блоки распределителя узлов, отнесённые к числу живых узлов
+    // Распределитель общий для типов с одинаковым размером узла, поэтому считается по живым узлам
+    template <typename Type>
+    double ListBytesPerElement()
+    {
+        SingleLinkedList<Type> list;
+
+        for(size_t i = 0; i < kElementCount; ++i)
+        {
+            list.PushFront(Type{});
+        }
+
+        const auto stats = SingleLinkedList<Type>::Arena::Instance().GetStats();
+
+        return static_cast<double>(stats.reserved_bytes) / stats.live_count;
+    }
+
+    template <typename Type>
+    void ReportFootprint(const char* name)
+    {
+        const double plain = PlainBytesPerElement<Type>();
+        const double list = ListBytesPerElement<Type>();
+
+        std::printf("%-14s %10zu %12.1f %10.1f %10.1f\n", name, sizeof(PlainNode<Type>), plain, list, plain - list);
+    }
+
+    struct Triple
+    {
+        std::int32_t a;
+        std::int32_t b;
+        std::int32_t c;
+    };
+}
+
+// Расход памяти на элемент: узел {значение, указатель} через malloc против упакованного узла из блоков точного размера
+void BenchmarkFootprint()
+{
+    std::printf("footprint, %zu elements\n", kElementCount);
+    std::printf("%-14s %10s %12s %10s %10s\n", "type", "plain node", "plain bytes", "list bytes", "saved");
+
+    ReportFootprint<char>("char");
+    ReportFootprint<std::int32_t>("int32_t");
+    ReportFootprint<std::int64_t>("int64_t");
+    ReportFootprint<Triple>("3 x int32_t");
+    ReportFootprint<std::string>("std::string");
+}
+
+namespace
+{
+    // Строки длиннее буфера SSO, чтобы у каждого элемента был свой блок в куче
+    std::vector<std::string> MakeRandomStrings(size_t count)
+    {
+        std::mt19937_64 random(42);
+        std::vector<std::string> values;
+        values.reserve(count);
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            values.push_back("element-" + std::to_string(random()) + "-with-heap-storage");
+        }
+
+        return values;
+    }
+
+    template <typename Function>
+    double MeasureNanoseconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+namespace
+{
+    // Список из values, узлы которого перевязаны сортировкой в случайном относительно адресов порядке,
+    // так что обход цепочки скачет по памяти
+    SingleLinkedList<std::string> MakeFragmentedList(const std::vector<std::string>& values)
+    {
+        SingleLinkedList<std::string> list;
+        auto last = list.before_begin();
+
+        for(const std::string& value : values)
+        {
+            last = list.InsertAfter(last, value);
+        }
+
+        list.PartialSort(values.size());
+
+        return list;
+    }
+}
+
+/*
+ * Время уничтожения фрагментированного списка строк: Clear() с предвыборкой и пакетным освобождением
+ * против удаления узлов по одному через PopFront() с тем же распределителем
+ */
+void BenchmarkClear()
+{
+    constexpr size_t kCount = 2000000;
+    const std::vector<std::string> values = MakeRandomStrings(kCount);
+
+    SingleLinkedList<std::string> list = MakeFragmentedList(values);
+    const double clear_ns = MeasureNanoseconds([&list]()
+    {
+        list.Clear();
+    });
+
+    list = MakeFragmentedList(values);
+    const double pop_ns = MeasureNanoseconds([&list]()
+    {
+        while(!list.IsEmpty())
+        {
+            list.PopFront();
+        }
+    });
+
+    std::printf("\nteardown of a fragmented list, %zu strings\n", kCount);
+    std::printf("%-28s %8.1f ns/element\n", "Clear()", clear_ns / kCount);
+    std::printf("%-28s %8.1f ns/element\n", "PopFront() one by one", pop_ns / kCount);
+}
+
+namespace
+{
+    // Резидентный размер процесса в МиБ
+    double ResidentMebibytes()
+    {
+        std::FILE* file = std::fopen("/proc/self/statm", "r");
+        unsigned long size = 0;
+        unsigned long resident = 0;
+
+        if(file != nullptr)
+        {
+            if(std::fscanf(file, "%lu %lu", &size, &resident) != 2)
+            {
+                resident = 0;
+            }
+
+            std::fclose(file);
+        }
+
+        return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+    }
+}
+
+// Резидентная память до и после возврата пустых блоков системе через ReleaseNodeMemory()
+void BenchmarkRelease()
+{
+    constexpr size_t kCount = 4000000;
+    SingleLinkedList<std::int64_t> list;
+
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        list.PushFront(static_cast<std::int64_t>(i));
+    }
+
+    const double filled = ResidentMebibytes();
+    list.Clear();
+    const double cleared = ResidentMebibytes();
+    size_t released_slabs = 0;
+    const double release_ns = MeasureNanoseconds([&released_slabs]()
+    {
+        released_slabs = ReleaseNodeMemory();
+    });
+    const double released = ResidentMebibytes();
+
+    std::printf("\nresident memory, %zu int64 elements\n", kCount);
+    std::printf("%-28s %8.1f MiB\n", "filled", filled);
+    std::printf("%-28s %8.1f MiB\n", "after Clear()", cleared);
+    std::printf("%-28s %8.1f MiB (%zu slabs in %.1f ms)\n", "after ReleaseNodeMemory()", released, released_slabs,
+                release_ns / 1e6);
+}
+
+namespace
+{
+    // Прежняя передача записей между стадиями: список под мьютексом
+    template <typename Type>
+    class MutexListQueue
+    {
+        public:
+            void Push(Type value)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                last_ = list_.InsertAfter(list_.IsEmpty() ? list_.cbefore_begin() : last_, std::move(value));
+            }
+
+            std::optional<Type> TryPop()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                if(list_.IsEmpty())
+                {
+                    return std::nullopt;
+                }
+
+                std::optional<Type> value(std::move(*list_.begin()));
+                list_.PopFront();
+
+                return value;
+            }
+
+        private:
+            std::mutex mutex_;
+            SingleLinkedList<Type> list_;
+            typename SingleLinkedList<Type>::ConstIterator last_;
+    };
+
+    // Среднее время обмена одним сообщением туда и обратно между двумя потоками через пару очередей
+    template <typename Queue>
+    double MeasureRoundTripNanoseconds(size_t round_trips)
+    {
+        Queue ping;
+        Queue pong;
+
+        std::thread echo([&ping, &pong, round_trips]()
+        {
+            for(size_t i = 0; i < round_trips; )
+            {
+                if(auto value = ping.TryPop())
+                {
+                    pong.Push(*value);
+                    ++i;
+                }
+                else
+                {
+                    // На одном ядре без уступки ожидание длится до конца кванта
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        const double total_ns = MeasureNanoseconds([&ping, &pong, round_trips]()
+        {
+            for(size_t i = 0; i < round_trips; ++i)
+            {
+                ping.Push(static_cast<std::int64_t>(i));
+
+                while(!pong.TryPop())
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        echo.join();
+
+        return total_ns / static_cast<double>(round_trips);
+    }
+}
+
+// Задержка передачи между двумя потоками: очередь SPSC против списка под мьютексом
+void BenchmarkPingPong()
+{
+    constexpr size_t kRoundTrips = 200000;
+
+    std::printf("\nping-pong between two threads, %zu round trips\n", kRoundTrips);
+    std::printf("%-28s %8.1f ns/round trip\n", "SpscQueue",
+                MeasureRoundTripNanoseconds<SpscQueue<std::int64_t>>(kRoundTrips));
+    std::printf("%-28s %8.1f ns/round trip\n", "mutex + SingleLinkedList",
+                MeasureRoundTripNanoseconds<MutexListQueue<std::int64_t>>(kRoundTrips));
+}
+
+namespace
+{
+    // Хеш-таблица с блокировками по полосам: ключи делятся между kStripeCount таблицами под своими мьютексами
+    template <typename Key, typename Value>
+    class StripedMap
+    {
+        public:
+            bool Insert(const Key& key, const Value& value)
+            {
+                Stripe& stripe = GetStripe(key);
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+
+                return stripe.map.emplace(key, value).second;
+            }
+
+            bool Erase(const Key& key)
+            {
+                Stripe& stripe = GetStripe(key);
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+
+                return stripe.map.erase(key) != 0;
+            }
+
+            std::optional<Value> Find(const Key& key)
+            {
+                Stripe& stripe = GetStripe(key);
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+                auto it = stripe.map.find(key);
+
+                return it == stripe.map.end() ? std::nullopt : std::optional<Value>(it->second);
+            }
+
+        private:
+            static constexpr size_t kStripeCount = 64;
+
+            struct alignas(64) Stripe
+            {
+                std::mutex mutex;
+                std::unordered_map<Key, Value> map;
+            };
+
+            Stripe& GetStripe(const Key& key)
+            {
+                return stripes_[std::hash<Key>()(key) * 0x9E3779B97F4A7C15 >> 58];
+            }
+
+            Stripe stripes_[kStripeCount];
+    };
+
+    std::atomic<size_t> found_sink{0};
+
+    // 1 и 4 потока и по одному на каждое ядро
+    std::vector<size_t> BenchmarkThreadCounts()
+    {
+        std::vector<size_t> thread_counts{1, 4};
+        const size_t core_count = std::thread::hardware_concurrency();
+
+        if(core_count != 1 && core_count != 4)
+        {
+            thread_counts.push_back(core_count);
+        }
+
+        return thread_counts;
+    }
+
+    // Операций в секунду (в миллионах) на смеси поиска с write_percent процентами изменений:
+    // поровну вставок и удалений случайных ключей в изначально пустом словаре
+    template <typename Map>
+    double MeasureMapMops(size_t thread_count, size_t operations_per_thread, std::uint64_t write_percent)
+    {
+        Map map;
+        std::vector<std::thread> threads;
+
+        const double total_ns = MeasureNanoseconds([&map, &threads, thread_count, operations_per_thread, write_percent]()
+        {
+            for(size_t t = 0; t < thread_count; ++t)
+            {
+                threads.emplace_back([&map, t, operations_per_thread, write_percent]()
+                {
+                    std::mt19937_64 random(t);
+                    size_t found_count = 0;
+
+                    for(size_t i = 0; i < operations_per_thread; ++i)
+                    {
+                        const std::uint64_t key = random() % (operations_per_thread * 4);
+                        const std::uint64_t action = random() % 100;
+
+                        if(action < write_percent / 2)
+                        {
+                            map.Insert(key, key);
+                        }
+                        else if(action < write_percent)
+                        {
+                            map.Erase(key);
+                        }
+                        else if(map.Find(key))
+                        {
+                            ++found_count;
+                        }
+                    }
+
+                    // Результат поиска используется, чтобы компилятор не выбросил его
+                    found_sink += found_count;
+                });
+            }
+
+            for(std::thread& thread : threads)
+            {
+                thread.join();
+            }
+        });
+
+        return static_cast<double>(thread_count * operations_per_thread) / total_ns * 1e3;
+    }
+}
+
+// Пропускная способность хеш-таблиц при одновременном доступе: SplitOrderedMap против блокировок по полосам
+void BenchmarkConcurrentMap()
+{
+    constexpr size_t kOperationsPerThread = 1000000;
+
+    std::printf("\nconcurrent hash map, 80%% find / 10%% insert / 10%% erase, %zu operations per thread\n",
+                kOperationsPerThread);
+    std::printf("%-8s %16s %16s\n", "threads", "SplitOrderedMap", "striped locks");
+
+    for(size_t thread_count : BenchmarkThreadCounts())
+    {
+        std::printf("%-8zu %10.2f Mop/s %10.2f Mop/s\n", thread_count,
+                    MeasureMapMops<SplitOrderedMap<std::uint64_t, std::uint64_t>>(thread_count, kOperationsPerThread, 20),
+                    MeasureMapMops<StripedMap<std::uint64_t, std::uint64_t>>(thread_count, kOperationsPerThread, 20));
+    }
+}
+
+namespace
+{
+    // Упорядоченный словарь под блокировкой чтения-записи
+    template <typename Key, typename Value>
+    class SharedMutexMap
+    {
+        public:
+            bool Insert(const Key& key, const Value& value)
+            {
+                std::unique_lock<std::shared_mutex> lock(mutex_);
+
+                return map_.emplace(key, value).second;
+            }
+
+            bool Erase(const Key& key)
+            {
+                std::unique_lock<std::shared_mutex> lock(mutex_);
+
+                return map_.erase(key) != 0;
+            }
+
+            std::optional<Value> Find(const Key& key)
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                auto it = map_.find(key);
+
+                return it == map_.end() ? std::nullopt : std::optional<Value>(it->second);
+            }
+
+        private:
+            std::shared_mutex mutex_;
+            std::map<Key, Value> map_;
+    };
+}
+
+// Пропускная способность упорядоченных словарей при разных долях изменений: SkipListMap против std::map под shared_mutex
+void BenchmarkConcurrentOrderedMap()
+{
+    constexpr size_t kOperationsPerThread = 1000000;
+
+    std::printf("\nconcurrent ordered map, %zu operations per thread\n", kOperationsPerThread);
+    std::printf("%-8s %-8s %16s %16s\n", "writes", "threads", "SkipListMap", "std::map+rwlock");
+
+    for(std::uint64_t write_percent : {5, 50})
+    {
+        for(size_t thread_count : BenchmarkThreadCounts())
+        {
+            std::printf("%-8s %-8zu %10.2f Mop/s %10.2f Mop/s\n", (std::to_string(write_percent) + "%").c_str(),
+                        thread_count,
+                        MeasureMapMops<SkipListMap<std::uint64_t, std::uint64_t>>(thread_count, kOperationsPerThread,
+                                                                                 write_percent),
+                        MeasureMapMops<SharedMutexMap<std::uint64_t, std::uint64_t>>(thread_count, kOperationsPerThread,
+                                                                                    write_percent));
+        }
+    }
+}
+
+int main()
+{
+    BenchmarkFootprint();
+    BenchmarkClear();
+    BenchmarkRelease();
+    BenchmarkPingPong();
+    BenchmarkConcurrentMap();
+    BenchmarkConcurrentOrderedMap();
+}
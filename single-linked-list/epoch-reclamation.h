@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+ * Освобождение памяти по эпохам (epoch-based reclamation) для структур без блокировок
+ * Поток читает общие узлы только внутри EpochReclamation::Guard. Узел, исключённый из структуры,
+ * не освобождается сразу, а передаётся в Retire() и освобождается, когда все потоки, которые могли
+ * его видеть, вышли из своих Guard: глобальная эпоха продвигается, только когда каждый поток
+ * внутри Guard уже наблюдал текущую эпоху, поэтому узлы, исключённые в эпоху e, недоступны,
+ * начиная с эпохи e + 2
+ * Один экземпляр на процесс, общий для всех структур; узлы освобождаются функцией, переданной
+ * в Retire(), и не зависят от структуры, из которой исключены
+ */
+class EpochReclamation
+{
+    struct Record;
+
+    public:
+        // Поток находится внутри Guard от его создания до разрушения. Guard может быть вложенным
+        class Guard
+        {
+            public:
+                Guard() : record_(Instance().Enter())
+                {
+                }
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+
+                ~Guard()
+                {
+                    Instance().Exit(record_);
+                }
+
+            private:
+                Record* record_;
+        };
+
+        static EpochReclamation& Instance()
+        {
+            // Намеренно не разрушается: потоки могут выходить из Guard и освобождать узлы после выхода из main
+            static EpochReclamation* instance = new EpochReclamation();
+
+            return *instance;
+        }
+
+        EpochReclamation(const EpochReclamation&) = delete;
+        EpochReclamation& operator=(const EpochReclamation&) = delete;
+
+        // Передаёт pointer на отложенное освобождение функцией deleter. Узел уже недоступен новым читателям
+        void Retire(void* pointer, void (*deleter)(void*))
+        {
+            Record* record = LocalRecord();
+            record->retired.push_back(Retired{pointer, deleter, epoch_.load()});
+
+            if(record->retired.size() >= kCollectThreshold)
+            {
+                Collect(*record);
+            }
+        }
+
+        // Пытается продвинуть эпоху и освобождает узлы текущего потока, которые стали недоступны
+        void Collect()
+        {
+            Collect(*LocalRecord());
+        }
+
+    private:
+        struct Retired
+        {
+            void* pointer;
+            void (*deleter)(void*);
+            std::uint64_t epoch;
+        };
+
+        // Состояние потока. Записи не удаляются, а после завершения потока достаются новым потокам
+        struct Record
+        {
+            // Эпоха, наблюдаемая потоком внутри Guard, сдвинутая на бит, и признак kActive
+            std::atomic<std::uint64_t> state{0};
+            std::atomic<bool> in_use{true};
+            Record* next = nullptr;
+            size_t nesting = 0;
+            // Исключённые потоком узлы в порядке неубывания эпох
+            std::vector<Retired> retired;
+        };
+
+        // Освобождает запись при завершении потока
+        struct LocalHolder
+        {
+            Record* record = nullptr;
+
+            ~LocalHolder()
+            {
+                if(record != nullptr)
+                {
+                    Instance().ReleaseRecord(record);
+                }
+            }
+        };
+
+        static constexpr std::uint64_t kActive = 1;
+        static constexpr size_t kCollectThreshold = 128;
+
+        EpochReclamation() = default;
+
+        Record* LocalRecord()
+        {
+            static thread_local LocalHolder holder;
+
+            if(holder.record == nullptr)
+            {
+                holder.record = AcquireRecord();
+            }
+
+            return holder.record;
+        }
+
+        Record* Enter()
+        {
+            Record* record = LocalRecord();
+
+            if(record->nesting++ == 0)
+            {
+                // Последовательная согласованность гарантирует, что продвигающий эпоху поток либо увидит
+                // эту запись, либо этот поток увидит уже продвинутую эпоху и узлы, исключённые до неё
+                record->state.store(epoch_.load() << 1 | kActive);
+            }
+
+            return record;
+        }
+
+        void Exit(Record* record) noexcept
+        {
+            assert(record->nesting != 0);
+
+            if(--record->nesting == 0)
+            {
+                record->state.store(0, std::memory_order_release);
+            }
+        }
+
+        // Продвигает эпоху, если все потоки внутри Guard наблюдают текущую
+        void TryAdvance() noexcept
+        {
+            std::uint64_t epoch = epoch_.load();
+
+            for(Record* record = records_.load(std::memory_order_acquire); record != nullptr; record = record->next)
+            {
+                const std::uint64_t state = record->state.load();
+
+                if((state & kActive) != 0 && state >> 1 != epoch)
+                {
+                    return;
+                }
+            }
+
+            epoch_.compare_exchange_strong(epoch, epoch + 1);
+        }
+
+        void Collect(Record& record)
+        {
+            TryAdvance();
+            FreeExpired(record.retired, epoch_.load());
+
+            std::unique_lock<std::mutex> lock(orphans_mutex_, std::try_to_lock);
+
+            if(lock.owns_lock())
+            {
+                FreeExpired(orphans_, epoch_.load());
+            }
+        }
+
+        // Освобождает узлы, исключённые не позже чем за две эпохи до epoch
+        static void FreeExpired(std::vector<Retired>& retired, std::uint64_t epoch)
+        {
+            size_t count = 0;
+
+            while(count < retired.size() && retired[count].epoch + 2 <= epoch)
+            {
+                retired[count].deleter(retired[count].pointer);
+                ++count;
+            }
+
+            retired.erase(retired.begin(), retired.begin() + static_cast<std::ptrdiff_t>(count));
+        }
+
+        Record* AcquireRecord()
+        {
+            for(Record* record = records_.load(std::memory_order_acquire); record != nullptr; record = record->next)
+            {
+                bool in_use = false;
+
+                if(record->in_use.compare_exchange_strong(in_use, true))
+                {
+                    return record;
+                }
+            }
+
+            Record* record = new Record();
+            record->next = records_.load(std::memory_order_relaxed);
+
+            while(!records_.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                                  std::memory_order_relaxed))
+            {
+            }
+
+            return record;
+        }
+
+        // Узлы завершившегося потока освобождаются другими потоками
+        void ReleaseRecord(Record* record)
+        {
+            if(!record->retired.empty())
+            {
+                std::lock_guard<std::mutex> lock(orphans_mutex_);
+                orphans_.insert(orphans_.end(), record->retired.begin(), record->retired.end());
+                std::sort(orphans_.begin(), orphans_.end(), [](const Retired& lhs, const Retired& rhs)
+                {
+                    return lhs.epoch < rhs.epoch;
+                });
+                record->retired.clear();
+            }
+
+            record->in_use.store(false, std::memory_order_release);
+        }
+
+        std::atomic<std::uint64_t> epoch_{0};
+        std::atomic<Record*> records_{nullptr};
+        std::mutex orphans_mutex_;
+        // Узлы завершившихся потоков в порядке неубывания эпох
+        std::vector<Retired> orphans_;
+};
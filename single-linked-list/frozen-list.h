@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+template <typename Type>
+class SingleLinkedList;
+
+/*
+ * Неизменяемое представление списка для многократного чтения, получаемое методом SingleLinkedList::Freeze()
+ * Значения хранятся в одном непрерывном блоке памяти в порядке следования элементов списка, поэтому
+ * обход выполняется со скоростью обхода вектора, доступ по номеру — за O(1), а data()/GetSize()
+ * дают непрерывный диапазон, пригодный для векторизованной обработки
+ * Метод Thaw() возвращает изменяемый список
+ */
+template <typename Type>
+class FrozenList
+{
+    public:
+        using value_type = Type;
+        using const_reference = const value_type&;
+        using ConstIterator = const Type*;
+
+        FrozenList() = default;
+
+        explicit FrozenList(std::vector<Type> values) noexcept : values_(std::move(values))
+        {
+        }
+
+        [[nodiscard]] ConstIterator begin() const noexcept
+        {
+            return values_.data();
+        }
+
+        [[nodiscard]] ConstIterator end() const noexcept
+        {
+            return values_.data() + values_.size();
+        }
+
+        [[nodiscard]] ConstIterator cbegin() const noexcept
+        {
+            return begin();
+        }
+
+        [[nodiscard]] ConstIterator cend() const noexcept
+        {
+            return end();
+        }
+
+        // Возвращает ссылку на элемент с номером index за время O(1)
+        [[nodiscard]] const_reference operator[](size_t index) const noexcept
+        {
+            assert(index < values_.size());
+
+            return values_[index];
+        }
+
+        // Указатель на непрерывный блок из GetSize() значений
+        [[nodiscard]] const Type* data() const noexcept
+        {
+            return values_.data();
+        }
+
+        [[nodiscard]] size_t GetSize() const noexcept
+        {
+            return values_.size();
+        }
+
+        [[nodiscard]] bool IsEmpty() const noexcept
+        {
+            return values_.empty();
+        }
+
+        // Возвращает изменяемый список с копиями значений
+        [[nodiscard]] SingleLinkedList<Type> Thaw() const&
+        {
+            SingleLinkedList<Type> list;
+            auto last = list.before_begin();
+
+            for(const Type& value : values_)
+            {
+                last = list.InsertAfter(last, value);
+            }
+
+            return list;
+        }
+
+        // Возвращает изменяемый список, перемещая в него значения. FrozenList становится пустым
+        [[nodiscard]] SingleLinkedList<Type> Thaw() &&
+        {
+            SingleLinkedList<Type> list;
+            auto last = list.before_begin();
+
+            for(Type& value : values_)
+            {
+                last = list.InsertAfter(last, std::move(value));
+            }
+
+            values_.clear();
+
+            return list;
+        }
+
+    private:
+        std::vector<Type> values_;
+};
+
+template <typename Type>
+bool operator==(const FrozenList<Type>& lhs, const FrozenList<Type>& rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <typename Type>
+bool operator!=(const FrozenList<Type>& lhs, const FrozenList<Type>& rhs)
+{
+    return !(lhs == rhs);
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+#include "single-linked-list.h"
+
+/*
+ * Ленивый список: вычисленное начало хранится в обычном SingleLinkedList, а хвост задан
+ * невычисленным генератором (thunk). Очередной элемент вычисляется при первом обращении
+ * к нему через итератор и запоминается в новом узле, поэтому повторные обходы генератор не вызывают
+ * Генератор возвращает следующий элемент либо std::nullopt, если последовательность закончилась;
+ * бесконечные последовательности допустимы, пока обход не идёт до конца
+ * Вычисленная часть — обычный SingleLinkedList с теми же узлами, и ReleaseForced() отдаёт её
+ * без копирования
+ */
+template <typename Type>
+class LazyList
+{
+    public:
+        using value_type = Type;
+        using Generator = std::function<std::optional<Type>()>;
+
+        /*
+         * Итератор ленивого списка. Переход за последний вычисленный элемент вычисляет следующий
+         * Итераторы становятся недействительными при перемещении списка
+         */
+        class Iterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const Type*;
+                using reference = const Type&;
+
+                Iterator() = default;
+
+                [[nodiscard]] bool operator==(const Iterator& rhs) const noexcept
+                {
+                    return position_ == rhs.position_;
+                }
+
+                [[nodiscard]] bool operator!=(const Iterator& rhs) const noexcept
+                {
+                    return !(*this == rhs);
+                }
+
+                // Если следующий элемент ещё не вычислен, вызывает генератор
+                // Исключение генератора не меняет ни итератор, ни список
+                Iterator& operator++()
+                {
+                    assert(list_ != nullptr && position_ != ListIterator{});
+
+                    auto next = std::next(position_);
+
+                    if(next == ListIterator{} && list_->ForceNext())
+                    {
+                        next = std::next(position_);
+                    }
+
+                    position_ = next;
+
+                    return *this;
+                }
+
+                Iterator operator++(int)
+                {
+                    auto old_value(*this);
+                    ++(*this);
+                    return old_value;
+                }
+
+                [[nodiscard]] reference operator*() const noexcept
+                {
+                    return *position_;
+                }
+
+                [[nodiscard]] pointer operator->() const noexcept
+                {
+                    return &*position_;
+                }
+
+            private:
+                using ListIterator = typename SingleLinkedList<Type>::ConstIterator;
+
+                friend class LazyList;
+
+                Iterator(LazyList* list, ListIterator position) noexcept : list_(list), position_(position)
+                {
+                }
+
+                LazyList* list_ = nullptr;
+                ListIterator position_;
+        };
+
+        LazyList() = default;
+
+        explicit LazyList(Generator generator) : generator_(std::move(generator))
+        {
+        }
+
+        // Ленивый список с уже вычисленным началом prefix, за которым следуют элементы генератора
+        LazyList(SingleLinkedList<Type> prefix, Generator generator)
+            : forced_(std::move(prefix)), generator_(std::move(generator))
+        {
+            assert(forced_.GetErasedCount() == 0);
+
+            for(auto it = forced_.cbegin(); it != forced_.cend(); ++it)
+            {
+                last_ = it;
+            }
+        }
+
+        LazyList(const LazyList&) = delete;
+        LazyList& operator=(const LazyList&) = delete;
+        LazyList(LazyList&&) noexcept = default;
+        LazyList& operator=(LazyList&&) noexcept = default;
+
+        // Возвращает итератор на первый элемент, вычисляя его при необходимости
+        [[nodiscard]] Iterator begin()
+        {
+            if(forced_.IsEmpty())
+            {
+                ForceNext();
+            }
+
+            return Iterator{this, forced_.cbegin()};
+        }
+
+        [[nodiscard]] Iterator end() noexcept
+        {
+            return Iterator{this, {}};
+        }
+
+        // Вычисляет ещё не более count элементов. Возвращает число вычисленных
+        size_t Force(size_t count)
+        {
+            size_t forced_count = 0;
+
+            while(forced_count < count && ForceNext())
+            {
+                ++forced_count;
+            }
+
+            return forced_count;
+        }
+
+        // Вычисляет все оставшиеся элементы. Для бесконечной последовательности не завершается
+        void ForceAll()
+        {
+            while(ForceNext())
+            {
+            }
+        }
+
+        // Сообщает, что генератор исчерпан и все элементы вычислены
+        [[nodiscard]] bool IsExhausted() const noexcept
+        {
+            return !generator_;
+        }
+
+        // Уже вычисленные элементы
+        [[nodiscard]] const SingleLinkedList<Type>& GetForced() const noexcept
+        {
+            return forced_;
+        }
+
+        // Отдаёт вычисленные элементы без копирования; невычисленный хвост отбрасывается
+        [[nodiscard]] SingleLinkedList<Type> ReleaseForced() &&
+        {
+            generator_ = nullptr;
+
+            return std::move(forced_);
+        }
+
+    private:
+        // Вычисляет следующий элемент и дописывает его в конец. Возвращает false, если генератор исчерпан
+        bool ForceNext()
+        {
+            if(!generator_)
+            {
+                return false;
+            }
+
+            std::optional<Type> value = generator_();
+
+            if(!value)
+            {
+                // Захваченные генератором ресурсы больше не нужны
+                generator_ = nullptr;
+
+                return false;
+            }
+
+            last_ = forced_.InsertAfter(forced_.IsEmpty() ? forced_.cbefore_begin() : last_, std::move(*value));
+
+            return true;
+        }
+
+        SingleLinkedList<Type> forced_;
+        // Последний вычисленный элемент; действителен, только если forced_ не пуст
+        typename SingleLinkedList<Type>::ConstIterator last_;
+        Generator generator_;
+};
@@ -0,0 +1,565 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "frozen-list.h"
+#include "list-executor.h"
+#include "list-stream.h"
+#include "single-linked-list.h"
+
+struct AsyncListIoOptions
+{
+    // Количество элементов в одном блоке файла при сохранении
+    size_t chunk_elements = 4096;
+    // Размер одной операции чтения при загрузке
+    size_t read_block_size = 1 << 20;
+    // Сколько операций ввода-вывода выполняется одновременно
+    unsigned queue_depth = 16;
+    // Использовать io_uring, если ядро его поддерживает; иначе операции выполняются вызовами pread/pwrite
+    bool use_io_uring = true;
+};
+
+namespace list_async_io_detail
+{
+    /*
+     * Минимальная обёртка над io_uring на системных вызовах, без liburing
+     * Используется одним потоком: он и отправляет запросы, и забирает результаты
+     */
+    class IoUring
+    {
+        public:
+            // Возвращает nullptr, если ядро не поддерживает io_uring, он запрещён
+            // или ядро не знает операций IORING_OP_READ/IORING_OP_WRITE (до 5.6)
+            static std::unique_ptr<IoUring> TryCreate(unsigned entries) noexcept
+            {
+                std::unique_ptr<IoUring> ring(new IoUring());
+
+                return ring->Setup(entries) ? std::move(ring) : nullptr;
+            }
+
+            IoUring(const IoUring&) = delete;
+            IoUring& operator=(const IoUring&) = delete;
+
+            ~IoUring()
+            {
+                if(sqes_ != nullptr)
+                {
+                    ::munmap(sqes_, sqes_size_);
+                }
+
+                if(cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+                {
+                    ::munmap(cq_ring_, cq_ring_size_);
+                }
+
+                if(sq_ring_ != nullptr)
+                {
+                    ::munmap(sq_ring_, sq_ring_size_);
+                }
+
+                if(ring_fd_ != -1)
+                {
+                    ::close(ring_fd_);
+                }
+            }
+
+            [[nodiscard]] unsigned GetCapacity() const noexcept
+            {
+                return sq_entries_;
+            }
+
+            /*
+             * Отправляет одну операцию чтения или записи. Число незавершённых операций не должно превышать GetCapacity()
+             * Операция считается отправленной, как только попала в очередь: если ядру не хватает ресурсов
+             * (EAGAIN, EBUSY), она остаётся в очереди и передаётся ядру при следующем вызове Submit или Wait
+             */
+            void Submit(std::uint8_t opcode, int fd, const void* data, unsigned size, std::uint64_t offset, std::uint64_t user_data)
+            {
+                const unsigned tail = *sq_tail_;
+                const unsigned index = tail & *sq_mask_;
+
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = opcode;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<std::uint64_t>(data);
+                sqe.len = size;
+                sqe.off = offset;
+                sqe.user_data = user_data;
+
+                sq_array_[index] = index;
+                // Ядро должно увидеть заполненный элемент раньше нового хвоста очереди
+                __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+                ++unsubmitted_;
+
+                Enter(0, 0);
+            }
+
+            // Дожидается завершения одной операции
+            io_uring_cqe Wait()
+            {
+                while(true)
+                {
+                    const unsigned head = *cq_head_;
+
+                    if(head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+                    {
+                        const io_uring_cqe cqe = cqes_[head & *cq_mask_];
+                        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+                        --in_kernel_;
+
+                        return cqe;
+                    }
+
+                    Enter(1, IORING_ENTER_GETEVENTS);
+                }
+            }
+
+        private:
+            IoUring() = default;
+
+            bool Setup(unsigned entries) noexcept
+            {
+                io_uring_params params{};
+                ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+
+                if(ring_fd_ == -1)
+                {
+                    return false;
+                }
+
+                sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+                // Начиная с 5.4 обе очереди отображаются одним вызовом
+                if(params.features & IORING_FEAT_SINGLE_MMAP)
+                {
+                    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+                }
+
+                sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+
+                if(sq_ring_ == nullptr)
+                {
+                    return false;
+                }
+
+                cq_ring_ = params.features & IORING_FEAT_SINGLE_MMAP ? sq_ring_ : Map(cq_ring_size_, IORING_OFF_CQ_RING);
+                sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+                sqes_ = static_cast<io_uring_sqe*>(Map(sqes_size_, IORING_OFF_SQES));
+
+                if(cq_ring_ == nullptr || sqes_ == nullptr)
+                {
+                    return false;
+                }
+
+                char* sq = static_cast<char*>(sq_ring_);
+                char* cq = static_cast<char*>(cq_ring_);
+                sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                sq_entries_ = params.sq_entries;
+
+                return SupportsReadWrite();
+            }
+
+            /*
+             * На ядрах 5.1–5.5 io_uring уже есть, но операции IORING_OP_READ/IORING_OP_WRITE завершаются с -EINVAL
+             * Поддержка операций проверяется запросом IORING_REGISTER_PROBE; ядра без него (до 5.6)
+             * не поддерживают и этих операций
+             */
+            bool SupportsReadWrite() const noexcept
+            {
+                constexpr unsigned kOpCount = IORING_OP_WRITE + 1;
+
+                alignas(io_uring_probe) unsigned char storage[sizeof(io_uring_probe) + kOpCount * sizeof(io_uring_probe_op)] = {};
+                io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage);
+
+                if(::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, probe, kOpCount) == -1)
+                {
+                    return false;
+                }
+
+                const auto supported = [probe](unsigned opcode)
+                {
+                    return opcode < probe->ops_len && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+                };
+
+                return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+            }
+
+            void* Map(size_t size, off_t offset) const noexcept
+            {
+                void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+
+                return address == MAP_FAILED ? nullptr : address;
+            }
+
+            /*
+             * Передаёт ядру операции из очереди и, если min_complete != 0, ждёт завершений
+             * При нехватке ресурсов ядра операции остаются в очереди: отправка откладывается,
+             * а ожидание ждёт уже переданных операций либо повторяет попытку
+             */
+            void Enter(unsigned min_complete, unsigned flags)
+            {
+                unsigned to_submit = unsubmitted_;
+
+                while(true)
+                {
+                    const long result = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+
+                    if(result >= 0)
+                    {
+                        unsubmitted_ -= static_cast<unsigned>(result);
+                        in_kernel_ += static_cast<unsigned>(result);
+
+                        return;
+                    }
+
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    if(errno != EAGAIN && errno != EBUSY)
+                    {
+                        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                    }
+
+                    if(min_complete == 0)
+                    {
+                        return;
+                    }
+
+                    if(in_kernel_ != 0)
+                    {
+                        to_submit = 0;
+                    }
+                    else
+                    {
+                        sched_yield();
+                    }
+                }
+            }
+
+            int ring_fd_ = -1;
+            void* sq_ring_ = nullptr;
+            void* cq_ring_ = nullptr;
+            size_t sq_ring_size_ = 0;
+            size_t cq_ring_size_ = 0;
+            io_uring_sqe* sqes_ = nullptr;
+            size_t sqes_size_ = 0;
+            unsigned sq_entries_ = 0;
+
+            unsigned* sq_tail_ = nullptr;
+            unsigned* sq_mask_ = nullptr;
+            unsigned* sq_array_ = nullptr;
+            unsigned* cq_head_ = nullptr;
+            unsigned* cq_tail_ = nullptr;
+            unsigned* cq_mask_ = nullptr;
+            io_uring_cqe* cqes_ = nullptr;
+
+            // Операции в очереди, ещё не переданные ядру, и переданные, но ещё не завершённые
+            unsigned unsubmitted_ = 0;
+            unsigned in_kernel_ = 0;
+    };
+
+    /*
+     * Очередь блочных операций чтения и записи по смещениям в файле с ограниченной глубиной
+     * Через io_uring операции выполняются одновременно; без него — по одной вызовами pread/pwrite
+     * Короткие чтения и записи дополняются повторными операциями
+     */
+    class BlockIo
+    {
+        public:
+            BlockIo(int fd, unsigned queue_depth, bool use_io_uring) : fd_(fd)
+            {
+                assert(queue_depth != 0);
+
+                if(use_io_uring)
+                {
+                    ring_ = IoUring::TryCreate(queue_depth);
+                }
+
+                slots_.resize(ring_ != nullptr ? ring_->GetCapacity() : 1);
+
+                for(size_t i = 0; i < slots_.size(); ++i)
+                {
+                    free_slots_.push_back(i);
+                }
+            }
+
+            BlockIo(const BlockIo&) = delete;
+            BlockIo& operator=(const BlockIo&) = delete;
+
+            // Ядро не должно обращаться к буферам после их освобождения, поэтому незавершённые операции дожидаются
+            ~BlockIo()
+            {
+                try
+                {
+                    for(; in_flight_ != 0; --in_flight_)
+                    {
+                        ring_->Wait();
+                    }
+                }
+                catch(...)
+                {
+                }
+            }
+
+            [[nodiscard]] bool UsesIoUring() const noexcept
+            {
+                return ring_ != nullptr;
+            }
+
+            // Записывает buffer по смещению offset; буфер хранится до завершения записи
+            void SubmitWrite(std::string buffer, std::uint64_t offset)
+            {
+                Slot& slot = slots_[AcquireSlot()];
+                slot.buffer = std::move(buffer);
+                slot.data = slot.buffer.data();
+                slot.size = slot.buffer.size();
+                slot.offset = offset;
+                slot.write = true;
+                Start(slot);
+            }
+
+            // Читает size байт по смещению offset в data; память должна оставаться действительной до Drain()
+            void SubmitRead(char* data, size_t size, std::uint64_t offset)
+            {
+                Slot& slot = slots_[AcquireSlot()];
+                slot.buffer.clear();
+                slot.data = data;
+                slot.size = size;
+                slot.offset = offset;
+                slot.write = false;
+                Start(slot);
+            }
+
+            // Дожидается завершения всех отправленных операций
+            void Drain()
+            {
+                while(in_flight_ != 0)
+                {
+                    Complete();
+                }
+            }
+
+        private:
+            struct Slot
+            {
+                std::string buffer;
+                char* data = nullptr;
+                size_t size = 0;
+                std::uint64_t offset = 0;
+                bool write = false;
+            };
+
+            size_t AcquireSlot()
+            {
+                while(free_slots_.empty())
+                {
+                    Complete();
+                }
+
+                const size_t index = free_slots_.back();
+                free_slots_.pop_back();
+
+                return index;
+            }
+
+            void Start(Slot& slot)
+            {
+                if(ring_ != nullptr)
+                {
+                    // Ядро передаёт за одну операцию чуть меньше 2 ГиБ, поэтому большие блоки передаются частями по 1 ГиБ
+                    // Операция учитывается до отправки: если Submit выбросит исключение, деструктор всё равно
+                    // дождётся её, и ядро не обратится к освобождённому буферу
+                    const unsigned size = static_cast<unsigned>(std::min<size_t>(slot.size, 1u << 30));
+                    ++in_flight_;
+                    ring_->Submit(slot.write ? IORING_OP_WRITE : IORING_OP_READ, fd_, slot.data, size, slot.offset,
+                                  static_cast<std::uint64_t>(&slot - slots_.data()));
+
+                    return;
+                }
+
+                while(slot.size != 0)
+                {
+                    const ssize_t result = slot.write ? ::pwrite(fd_, slot.data, slot.size, static_cast<off_t>(slot.offset))
+                                                      : ::pread(fd_, slot.data, slot.size, static_cast<off_t>(slot.offset));
+
+                    if(result == -1 && errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    Advance(slot, result == -1 ? -errno : static_cast<int>(result));
+                }
+
+                Release(slot);
+            }
+
+            void Complete()
+            {
+                const io_uring_cqe cqe = ring_->Wait();
+                --in_flight_;
+                Slot& slot = slots_[cqe.user_data];
+
+                if(cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    Start(slot);
+
+                    return;
+                }
+
+                Advance(slot, cqe.res);
+
+                if(slot.size != 0)
+                {
+                    Start(slot);
+                }
+                else
+                {
+                    Release(slot);
+                }
+            }
+
+            // Учитывает результат операции: число переданных байт либо код ошибки со знаком минус
+            static void Advance(Slot& slot, int result)
+            {
+                if(result < 0)
+                {
+                    throw std::system_error(-result, std::generic_category(), slot.write ? "write" : "read");
+                }
+
+                if(result == 0)
+                {
+                    throw std::system_error(EIO, std::generic_category(), "unexpected end of file");
+                }
+
+                slot.data += result;
+                slot.size -= static_cast<size_t>(result);
+                slot.offset += static_cast<std::uint64_t>(result);
+            }
+
+            void Release(Slot& slot)
+            {
+                slot.buffer = std::string();
+                free_slots_.push_back(static_cast<size_t>(&slot - slots_.data()));
+            }
+
+            int fd_;
+            std::unique_ptr<IoUring> ring_;
+            std::vector<Slot> slots_;
+            std::vector<size_t> free_slots_;
+            // Число операций, отправленных в io_uring и ещё не завершённых
+            size_t in_flight_ = 0;
+    };
+}
+
+/*
+ * Асинхронно сохраняет снимок snapshot в fd с начала файла в формате SaveListStream
+ * Блоки кодируются в задаче на executor и записываются через io_uring по несколько одновременно,
+ * причём следующий блок кодируется, пока предыдущие ещё записываются
+ * Ошибки ввода-вывода передаются через future в виде std::system_error
+ * fd должен оставаться открытым до завершения операции
+ */
+template <typename Type>
+std::future<void> SaveListAsync(int fd, FrozenList<Type> snapshot, AsyncListIoOptions options = {},
+                                ListExecutor& executor = DefaultListExecutor())
+{
+    assert(options.chunk_elements != 0);
+
+    return Submit(executor, [fd, snapshot = std::move(snapshot), options]()
+    {
+        list_async_io_detail::BlockIo io(fd, options.queue_depth, options.use_io_uring);
+        io.SubmitWrite(std::string(list_stream_detail::kMagic, sizeof(list_stream_detail::kMagic)), 0);
+
+        std::uint64_t offset = sizeof(list_stream_detail::kMagic);
+        auto it = snapshot.begin();
+
+        while(true)
+        {
+            std::string chunk;
+            const std::uint64_t count = list_stream_detail::EncodeChunk(it, snapshot.end(), options.chunk_elements, chunk);
+            const size_t size = chunk.size();
+            io.SubmitWrite(std::move(chunk), offset);
+            offset += size;
+
+            if(count == 0)
+            {
+                break;
+            }
+        }
+
+        io.Drain();
+    });
+}
+
+/*
+ * Асинхронно сохраняет текущее содержимое списка. Значения копируются в неизменяемый снимок
+ * до возврата из функции, поэтому список можно изменять, не дожидаясь окончания записи
+ */
+template <typename Type>
+std::future<void> SaveListAsync(int fd, const SingleLinkedList<Type>& list, AsyncListIoOptions options = {},
+                                ListExecutor& executor = DefaultListExecutor())
+{
+    return SaveListAsync(fd, FrozenList<Type>(std::vector<Type>(list.begin(), list.end())), options, executor);
+}
+
+/*
+ * Асинхронно загружает список, сохранённый SaveListAsync или SaveListStream
+ * Файл читается блоками по options.read_block_size через io_uring, несколько блоков одновременно,
+ * затем разбирается; всё это выполняется задачей на executor
+ * Ошибки ввода-вывода передаются через future в виде std::system_error, повреждённые данные — std::runtime_error
+ */
+template <typename Type>
+std::future<SingleLinkedList<Type>> LoadListAsync(int fd, AsyncListIoOptions options = {},
+                                                  ListExecutor& executor = DefaultListExecutor())
+{
+    assert(options.read_block_size != 0);
+
+    return Submit(executor, [fd, options]()
+    {
+        struct stat status{};
+
+        if(::fstat(fd, &status) == -1)
+        {
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        }
+
+        std::string content(static_cast<size_t>(status.st_size), '\0');
+        list_async_io_detail::BlockIo io(fd, options.queue_depth, options.use_io_uring);
+
+        for(size_t offset = 0; offset < content.size(); offset += options.read_block_size)
+        {
+            io.SubmitRead(content.data() + offset, std::min(options.read_block_size, content.size() - offset), offset);
+        }
+
+        io.Drain();
+
+        return list_stream_detail::DecodeStream<Type>(content.data(), content.data() + content.size());
+    });
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/*
+ * Двоичное представление значений элементов списка для записи на диск
+ * Encode дописывает представление value в конец out
+ * Decode читает значение из [data, end), сдвигает data за прочитанное и возвращает false,
+ * если данных недостаточно
+ * По умолчанию поддерживаются тривиально копируемые типы (побайтовая копия) и std::string;
+ * для других типов нужна своя специализация
+ */
+template <typename Type>
+struct ListCodec
+{
+    static_assert(std::is_trivially_copyable_v<Type>, "ListCodec must be specialized for this type");
+
+    static void Encode(const Type& value, std::string& out)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(Type));
+    }
+
+    static bool Decode(const char*& data, const char* end, Type& value) noexcept
+    {
+        if(static_cast<size_t>(end - data) < sizeof(Type))
+        {
+            return false;
+        }
+
+        std::memcpy(&value, data, sizeof(Type));
+        data += sizeof(Type);
+
+        return true;
+    }
+};
+
+// Строка записывается как длина (uint64_t) и следующие за ней байты
+template <>
+struct ListCodec<std::string>
+{
+    static void Encode(const std::string& value, std::string& out)
+    {
+        ListCodec<std::uint64_t>::Encode(value.size(), out);
+        out.append(value);
+    }
+
+    static bool Decode(const char*& data, const char* end, std::string& value)
+    {
+        std::uint64_t length = 0;
+
+        if(!ListCodec<std::uint64_t>::Decode(data, end, length) || static_cast<std::uint64_t>(end - data) < length)
+        {
+            return false;
+        }
+
+        value.assign(data, static_cast<size_t>(length));
+        data += length;
+
+        return true;
+    }
+};
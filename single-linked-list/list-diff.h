@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "single-linked-list.h"
+
+/*
+ * Построение кратчайшего сценария правок между двумя последовательностями алгоритмом Майерса
+ * в варианте с линейной памятью: задача делится пополам по «средней змейке» (середине
+ * кратчайшего пути в графе правок), общие начало и конец каждой подзадачи отбрасываются сразу
+ * Время O((n + m) · D), память O(n + m), где D — длина сценария
+ */
+template <typename Type, typename Equal>
+class ListDiffer
+{
+    public:
+        using Edit = typename SingleLinkedList<Type>::Edit;
+        using EditType = typename SingleLinkedList<Type>::EditType;
+
+        ListDiffer(const SingleLinkedList<Type>& from, const SingleLinkedList<Type>& to, Equal equal)
+            : equal_(equal)
+        {
+            from_.reserve(from.GetSize());
+            to_.reserve(to.GetSize());
+
+            for(const Type& value : from)
+            {
+                from_.push_back(&value);
+            }
+
+            for(const Type& value : to)
+            {
+                to_.push_back(&value);
+            }
+        }
+
+        // Возвращает сценарий правок в формате SingleLinkedList::ApplyEdits
+        std::vector<Edit> Run()
+        {
+            Compare(0, from_.size(), 0, to_.size());
+
+            return std::move(script_);
+        }
+
+    private:
+        // Отрезок общего пути: из точки (x_begin, y_begin) в точку (x_end, y_end) по диагонали
+        struct Snake
+        {
+            size_t x_begin;
+            size_t y_begin;
+            size_t x_end;
+            size_t y_end;
+        };
+
+        void Compare(size_t from_begin, size_t from_end, size_t to_begin, size_t to_end)
+        {
+            while(from_begin < from_end && to_begin < to_end && equal_(*from_[from_begin], *to_[to_begin]))
+            {
+                ++from_begin;
+                ++to_begin;
+            }
+
+            while(from_begin < from_end && to_begin < to_end && equal_(*from_[from_end - 1], *to_[to_end - 1]))
+            {
+                --from_end;
+                --to_end;
+            }
+
+            if(from_begin == from_end)
+            {
+                for(size_t y = to_begin; y < to_end; ++y)
+                {
+                    script_.push_back(Edit{EditType::Insert, from_begin, *to_[y]});
+                }
+
+                return;
+            }
+
+            if(to_begin == to_end)
+            {
+                for(size_t x = from_begin; x < from_end; ++x)
+                {
+                    script_.push_back(Edit{EditType::Erase, x, Type{}});
+                }
+
+                return;
+            }
+
+            const Snake snake = FindMiddleSnake(from_begin, from_end - from_begin, to_begin, to_end - to_begin);
+
+            Compare(from_begin, from_begin + snake.x_begin, to_begin, to_begin + snake.y_begin);
+            Compare(from_begin + snake.x_end, from_end, to_begin + snake.y_end, to_end);
+        }
+
+        // Находит среднюю змейку для подзадачи from_[from_begin, +n) → to_[to_begin, +m)
+        // Координаты змейки отсчитываются от начала подзадачи
+        Snake FindMiddleSnake(size_t from_begin, size_t n, size_t to_begin, size_t m)
+        {
+            const auto from_at = [&](std::ptrdiff_t x) -> const Type& { return *from_[from_begin + x]; };
+            const auto to_at = [&](std::ptrdiff_t y) -> const Type& { return *to_[to_begin + y]; };
+
+            const std::ptrdiff_t width = static_cast<std::ptrdiff_t>(n);
+            const std::ptrdiff_t height = static_cast<std::ptrdiff_t>(m);
+            const std::ptrdiff_t delta = width - height;
+            const bool odd = (delta & 1) != 0;
+            const std::ptrdiff_t max_d = (width + height + 1) / 2;
+            const std::ptrdiff_t offset = max_d + 1;
+
+            // Самые дальние x на диагоналях k = x - y для прямого и обратного (с конца) поиска
+            forward_.assign(2 * max_d + 3, 0);
+            backward_.assign(2 * max_d + 3, 0);
+
+            for(std::ptrdiff_t d = 0; d <= max_d; ++d)
+            {
+                for(std::ptrdiff_t k = -d; k <= d; k += 2)
+                {
+                    std::ptrdiff_t x = (k == -d || (k != d && forward_[offset + k - 1] < forward_[offset + k + 1]))
+                                       ? forward_[offset + k + 1]
+                                       : forward_[offset + k - 1] + 1;
+                    std::ptrdiff_t y = x - k;
+                    const std::ptrdiff_t x_begin = x;
+                    const std::ptrdiff_t y_begin = y;
+
+                    while(x < width && y < height && equal_(from_at(x), to_at(y)))
+                    {
+                        ++x;
+                        ++y;
+                    }
+
+                    forward_[offset + k] = x;
+
+                    if(odd && k >= delta - (d - 1) && k <= delta + (d - 1) && x + backward_[offset + delta - k] >= width)
+                    {
+                        return Snake{static_cast<size_t>(x_begin), static_cast<size_t>(y_begin),
+                                     static_cast<size_t>(x), static_cast<size_t>(y)};
+                    }
+                }
+
+                for(std::ptrdiff_t k = -d; k <= d; k += 2)
+                {
+                    std::ptrdiff_t x = (k == -d || (k != d && backward_[offset + k - 1] < backward_[offset + k + 1]))
+                                       ? backward_[offset + k + 1]
+                                       : backward_[offset + k - 1] + 1;
+                    std::ptrdiff_t y = x - k;
+                    const std::ptrdiff_t x_begin = x;
+                    const std::ptrdiff_t y_begin = y;
+
+                    while(x < width && y < height && equal_(from_at(width - 1 - x), to_at(height - 1 - y)))
+                    {
+                        ++x;
+                        ++y;
+                    }
+
+                    backward_[offset + k] = x;
+
+                    if(!odd && k >= delta - d && k <= delta + d && x + forward_[offset + delta - k] >= width)
+                    {
+                        return Snake{static_cast<size_t>(width - x), static_cast<size_t>(height - y),
+                                     static_cast<size_t>(width - x_begin), static_cast<size_t>(height - y_begin)};
+                    }
+                }
+            }
+
+            // Пути из начала и с конца обязаны встретиться не позже шага max_d
+            assert(false);
+            return Snake{0, 0, 0, 0};
+        }
+
+        Equal equal_;
+        std::vector<const Type*> from_;
+        std::vector<const Type*> to_;
+        std::vector<std::ptrdiff_t> forward_;
+        std::vector<std::ptrdiff_t> backward_;
+        std::vector<typename SingleLinkedList<Type>::Edit> script_;
+};
+
+/*
+ * Возвращает кратчайший сценарий правок, превращающий список from в список to
+ * Совпадающие элементы в сценарий не попадают, поэтому его размер пропорционален объёму изменений
+ * Позиции правок относятся к списку from, формат совпадает с SingleLinkedList::ApplyEdits
+ */
+template <typename Type, typename Equal = std::equal_to<Type>>
+std::vector<typename SingleLinkedList<Type>::Edit> Diff(const SingleLinkedList<Type>& from, const SingleLinkedList<Type>& to,
+                                                        Equal equal = Equal{})
+{
+    return ListDiffer<Type, Equal>(from, to, equal).Run();
+}
+
+// Применяет к списку сценарий правок, построенный функцией Diff, за один проход
+template <typename Type>
+void Patch(SingleLinkedList<Type>& list, const std::vector<typename SingleLinkedList<Type>::Edit>& script)
+{
+    list.ApplyEdits(script);
+}
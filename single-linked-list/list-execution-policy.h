@@ -0,0 +1,24 @@
+#pragma once
+
+#include <execution>
+
+#include "list-executor.h"
+
+/*
+ * Переходники от стандартных политик выполнения к исполнителям списка
+ * Вынесены в отдельный заголовок: в libstdc++ <execution> требует компоновки с TBB
+ */
+inline ListExecutor& ExecutorFor(const std::execution::sequenced_policy&) noexcept
+{
+    return InlineExecutor::Instance();
+}
+
+inline ListExecutor& ExecutorFor(const std::execution::parallel_policy&)
+{
+    return DefaultListExecutor();
+}
+
+inline ListExecutor& ExecutorFor(const std::execution::parallel_unsequenced_policy&)
+{
+    return DefaultListExecutor();
+}
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Исполнитель задач для параллельных алгоритмов списка
+ * Все параллельные операции принимают исполнитель, поэтому приложение может отдать им
+ * один общий набор рабочих потоков вместо того, чтобы каждая операция создавала свои
+ * Execute должен рано или поздно выполнить задачу — в любом потоке, в том числе сразу в вызывающем
+ * Задачи исключений не выбрасывают
+ */
+class ListExecutor
+{
+    public:
+        virtual ~ListExecutor() = default;
+
+        virtual void Execute(std::function<void()> task) = 0;
+        // Сколько задач имеет смысл выполнять одновременно
+        [[nodiscard]] virtual size_t GetConcurrency() const noexcept = 0;
+
+        // Выполняется ли вызывающий код в рабочем потоке исполнителя; если это неизвестно — false
+        [[nodiscard]] virtual bool IsWorkerThread() const noexcept
+        {
+            return false;
+        }
+};
+
+// Выполняет задачи сразу в вызывающем потоке
+class InlineExecutor : public ListExecutor
+{
+    public:
+        void Execute(std::function<void()> task) override
+        {
+            task();
+        }
+
+        [[nodiscard]] size_t GetConcurrency() const noexcept override
+        {
+            return 1;
+        }
+
+        static InlineExecutor& Instance() noexcept
+        {
+            static InlineExecutor executor;
+
+            return executor;
+        }
+};
+
+/*
+ * Переходник к пулу потоков приложения: submit передаёт задачу в пул,
+ * concurrency — число его рабочих потоков
+ */
+class UserPoolExecutor : public ListExecutor
+{
+    public:
+        UserPoolExecutor(std::function<void(std::function<void()>)> submit, size_t concurrency)
+            : submit_(std::move(submit)), concurrency_(std::max<size_t>(1, concurrency))
+        {
+        }
+
+        void Execute(std::function<void()> task) override
+        {
+            submit_(std::move(task));
+        }
+
+        [[nodiscard]] size_t GetConcurrency() const noexcept override
+        {
+            return concurrency_;
+        }
+
+    private:
+        std::function<void(std::function<void()>)> submit_;
+        size_t concurrency_;
+};
+
+/*
+ * Пул потоков с перехватом работы (work stealing). У каждого рабочего потока своя очередь:
+ * задачи, порождённые в рабочем потоке, кладутся в его очередь и берутся из её конца (LIFO),
+ * а простаивающий поток забирает задачи из начала чужих очередей
+ * Потоки можно закрепить за ядрами (pin_threads). При разрушении пул выполняет все отправленные задачи
+ */
+class WorkStealingExecutor : public ListExecutor
+{
+    public:
+        // thread_count == 0 — по числу ядер
+        explicit WorkStealingExecutor(size_t thread_count = 0, bool pin_threads = false)
+        {
+            if(thread_count == 0)
+            {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            for(size_t i = 0; i < thread_count; ++i)
+            {
+                workers_.push_back(std::make_unique<Worker>());
+            }
+
+            for(size_t i = 0; i < thread_count; ++i)
+            {
+                workers_[i]->thread = std::thread([this, i]()
+                {
+                    Run(i);
+                });
+
+                if(pin_threads)
+                {
+                    cpu_set_t cpus;
+                    CPU_ZERO(&cpus);
+                    CPU_SET(static_cast<int>(i % std::max(1u, std::thread::hardware_concurrency())), &cpus);
+                    pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(cpus), &cpus);
+                }
+            }
+        }
+
+        WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+        WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+        ~WorkStealingExecutor()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                stopping_ = true;
+            }
+
+            wakeup_.notify_all();
+
+            for(auto& worker : workers_)
+            {
+                worker->thread.join();
+            }
+        }
+
+        void Execute(std::function<void()> task) override
+        {
+            const size_t index = current_pool_ == this ? current_index_
+                                                       : next_queue_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+            {
+                std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+                workers_[index]->tasks.push_back(std::move(task));
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                ++pending_;
+            }
+
+            wakeup_.notify_one();
+        }
+
+        [[nodiscard]] size_t GetConcurrency() const noexcept override
+        {
+            return workers_.size();
+        }
+
+        [[nodiscard]] bool IsWorkerThread() const noexcept override
+        {
+            return current_pool_ == this;
+        }
+
+        // Общий пул библиотеки с потоками по числу ядер; создаётся при первом обращении
+        static WorkStealingExecutor& Default()
+        {
+            static WorkStealingExecutor executor;
+
+            return executor;
+        }
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+            std::thread thread;
+        };
+
+        void Run(size_t index)
+        {
+            current_pool_ = this;
+            current_index_ = index;
+
+            while(true)
+            {
+                {
+                    // Поток резервирует одну из отправленных задач, а затем ищет её в очередях
+                    std::unique_lock<std::mutex> lock(sleep_mutex_);
+                    wakeup_.wait(lock, [this]()
+                    {
+                        return pending_ != 0 || stopping_;
+                    });
+
+                    if(pending_ == 0)
+                    {
+                        return;
+                    }
+
+                    --pending_;
+                }
+
+                std::function<void()> task;
+
+                while(!TakeTask(index, task))
+                {
+                    std::this_thread::yield();
+                }
+
+                task();
+            }
+        }
+
+        // Берёт задачу из конца своей очереди, иначе из начала чужой
+        bool TakeTask(size_t index, std::function<void()>& task)
+        {
+            for(size_t i = 0; i < workers_.size(); ++i)
+            {
+                Worker& worker = *workers_[(index + i) % workers_.size()];
+                std::lock_guard<std::mutex> lock(worker.mutex);
+
+                if(!worker.tasks.empty())
+                {
+                    if(i == 0)
+                    {
+                        task = std::move(worker.tasks.back());
+                        worker.tasks.pop_back();
+                    }
+                    else
+                    {
+                        task = std::move(worker.tasks.front());
+                        worker.tasks.pop_front();
+                    }
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::mutex sleep_mutex_;
+        std::condition_variable wakeup_;
+        // Число отправленных, но ещё не зарезервированных потоками задач
+        size_t pending_ = 0;
+        bool stopping_ = false;
+        std::atomic<size_t> next_queue_{0};
+
+        // Пул и номер рабочего потока, в котором выполняется код
+        static inline thread_local const WorkStealingExecutor* current_pool_ = nullptr;
+        static inline thread_local size_t current_index_ = 0;
+};
+
+// Исполнитель по умолчанию для параллельных операций списка
+inline ListExecutor& DefaultListExecutor()
+{
+    return WorkStealingExecutor::Default();
+}
+
+// Выполняет function на executor и возвращает future с её результатом или исключением
+template <typename Function>
+std::future<std::invoke_result_t<Function>> Submit(ListExecutor& executor, Function function)
+{
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    std::future<std::invoke_result_t<Function>> result = task->get_future();
+    executor.Execute([task]()
+    {
+        (*task)();
+    });
+
+    return result;
+}
+
+/*
+ * Вызывает function(i) для всех i из [0, count) и дожидается завершения
+ * Номера разбираются задачами исполнителя и вызывающим потоком из общего счётчика, поэтому
+ * вызов не блокируется, даже если сделан из рабочего потока того же пула, а все потоки пула заняты
+ * Первое выброшенное исключение передаётся вызывающему после завершения остальных вызовов;
+ * ещё не начатые вызовы после него пропускаются
+ */
+template <typename Function>
+void ParallelFor(ListExecutor& executor, size_t count, Function function)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    struct State
+    {
+        std::atomic<size_t> next_index{0};
+        std::atomic<bool> failed{false};
+        size_t done_count = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    auto state = std::make_shared<State>();
+
+    auto work = [state, count, &function]()
+    {
+        for(size_t i; (i = state->next_index.fetch_add(1)) < count; )
+        {
+            std::exception_ptr error;
+
+            if(!state->failed.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    function(i);
+                }
+                catch(...)
+                {
+                    error = std::current_exception();
+                    state->failed = true;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            if(error != nullptr && state->error == nullptr)
+            {
+                state->error = error;
+            }
+
+            if(++state->done_count == count)
+            {
+                state->done.notify_all();
+            }
+        }
+    };
+
+    // Каждая задача исполнителя, как и вызывающий поток, разбирает номера, пока они не кончатся;
+    // задача, запущенная после этого, сразу завершается и function не трогает
+    for(size_t i = 1; i < std::min(count, executor.GetConcurrency()); ++i)
+    {
+        executor.Execute(work);
+    }
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state, count]()
+    {
+        return state->done_count == count;
+    });
+
+    if(state->error != nullptr)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "single-linked-list.h"
+
+/*
+ * Позиция в списке байтовых буферов, с которой продолжается запись: текущий буфер и число
+ * уже записанных байт из него. Позволяет возобновить запись после частичного writev
+ * Buffer — любой тип с методами data() и size() и однобайтовыми элементами (std::string, std::vector<char>, ...)
+ */
+template <typename Buffer>
+struct GatherCursor
+{
+    typename SingleLinkedList<Buffer>::ConstIterator position;
+    size_t offset = 0;
+
+    // Сообщает, что все буферы записаны
+    [[nodiscard]] bool IsDone() const noexcept
+    {
+        return position == typename SingleLinkedList<Buffer>::ConstIterator{};
+    }
+};
+
+template <typename Buffer>
+[[nodiscard]] GatherCursor<Buffer> MakeGatherCursor(const SingleLinkedList<Buffer>& list) noexcept
+{
+    return GatherCursor<Buffer>{list.begin(), 0};
+}
+
+/*
+ * Заполняет out (не более max_count элементов) ссылками на ещё не записанные байты буферов списка,
+ * начиная с позиции cursor. Возвращает число заполненных элементов
+ * Данные не копируются: iovec указывают прямо в буферы списка. Пустые буферы пропускаются
+ */
+template <typename Buffer>
+size_t ToIovec(const GatherCursor<Buffer>& cursor, iovec* out, size_t max_count) noexcept
+{
+    static_assert(sizeof(*std::declval<const Buffer&>().data()) == 1, "Buffer elements must be bytes");
+
+    size_t count = 0;
+    size_t offset = cursor.offset;
+
+    for(auto it = cursor.position; it != typename SingleLinkedList<Buffer>::ConstIterator{} && count < max_count; ++it)
+    {
+        if(it->size() > offset)
+        {
+            out[count].iov_base = const_cast<void*>(static_cast<const void*>(it->data() + offset));
+            out[count].iov_len = it->size() - offset;
+            ++count;
+        }
+
+        offset = 0;
+    }
+
+    return count;
+}
+
+// Сдвигает cursor на bytes записанных байт
+template <typename Buffer>
+void AdvanceGatherCursor(GatherCursor<Buffer>& cursor, size_t bytes) noexcept
+{
+    while(!cursor.IsDone())
+    {
+        const size_t left = cursor.position->size() - cursor.offset;
+
+        if(bytes < left)
+        {
+            cursor.offset += bytes;
+            return;
+        }
+
+        bytes -= left;
+        ++cursor.position;
+        cursor.offset = 0;
+    }
+}
+
+/*
+ * Выполняет один вызов writev для очередной порции буферов и сдвигает cursor на записанное
+ * Возвращает число записанных байт; 0 — если неблокирующий дескриптор не готов к записи
+ * При ошибке записи выбрасывает std::system_error
+ */
+template <typename Buffer>
+size_t WriteSome(int fd, GatherCursor<Buffer>& cursor)
+{
+    constexpr size_t kBatchSize = 256;
+    iovec batch[kBatchSize];
+
+    while(true)
+    {
+        const size_t count = ToIovec(cursor, batch, kBatchSize);
+
+        if(count == 0)
+        {
+            // Остались только пустые буферы
+            cursor.position = {};
+            cursor.offset = 0;
+            return 0;
+        }
+
+        const ssize_t written = ::writev(fd, batch, static_cast<int>(count));
+
+        if(written == -1)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return 0;
+            }
+
+            throw std::system_error(errno, std::generic_category(), "writev");
+        }
+
+        AdvanceGatherCursor(cursor, static_cast<size_t>(written));
+
+        return static_cast<size_t>(written);
+    }
+}
+
+/*
+ * Записывает в fd содержимое всех буферов списка, начиная с cursor, без копирования в общий буфер
+ * Частичные записи продолжаются с места остановки; для неблокирующего дескриптора ожидается готовность
+ * Возвращает число записанных байт
+ */
+template <typename Buffer>
+size_t WriteAll(int fd, GatherCursor<Buffer>& cursor)
+{
+    size_t total = 0;
+
+    while(!cursor.IsDone())
+    {
+        const size_t written = WriteSome(fd, cursor);
+        total += written;
+
+        if(written == 0 && !cursor.IsDone())
+        {
+            pollfd descriptor{fd, POLLOUT, 0};
+
+            if(::poll(&descriptor, 1, -1) == -1 && errno != EINTR)
+            {
+                throw std::system_error(errno, std::generic_category(), "poll");
+            }
+        }
+    }
+
+    return total;
+}
+
+template <typename Buffer>
+size_t WriteAll(int fd, const SingleLinkedList<Buffer>& list)
+{
+    GatherCursor<Buffer> cursor = MakeGatherCursor(list);
+
+    return WriteAll(fd, cursor);
+}
+
+/*
+ * Файл, отображённый в память только для чтения. Отображение снимается в деструкторе
+ * Адрес данных не меняется при перемещении объекта
+ */
+class MappedFile
+{
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::string& path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+            if(fd == -1)
+            {
+                throw std::system_error(errno, std::generic_category(), "open " + path);
+            }
+
+            struct stat status{};
+
+            if(::fstat(fd, &status) == -1)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat " + path);
+            }
+
+            size_ = static_cast<size_t>(status.st_size);
+
+            // Пустой файл отобразить нельзя
+            if(size_ != 0)
+            {
+                void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if(data == MAP_FAILED)
+                {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(), "mmap " + path);
+                }
+
+                data_ = static_cast<const char*>(data);
+                ::madvise(data, size_, MADV_SEQUENTIAL);
+            }
+
+            ::close(fd);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+            : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+        {
+        }
+
+        MappedFile& operator=(MappedFile&& rhs) noexcept
+        {
+            if(this != &rhs)
+            {
+                Unmap();
+                data_ = std::exchange(rhs.data_, nullptr);
+                size_ = std::exchange(rhs.size_, 0);
+            }
+
+            return *this;
+        }
+
+        ~MappedFile()
+        {
+            Unmap();
+        }
+
+        [[nodiscard]] const char* data() const noexcept
+        {
+            return data_;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return size_;
+        }
+
+    private:
+        void Unmap() noexcept
+        {
+            if(data_ != nullptr)
+            {
+                ::munmap(const_cast<char*>(data_), size_);
+                data_ = nullptr;
+            }
+        }
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+};
+
+/*
+ * Список строк текстового файла, указывающих прямо в отображение файла в память
+ * Строки не копируются; отображение принадлежит объекту и снимается только после разрушения списка,
+ * поэтому string_view в списке действительны, пока жив объект
+ */
+class MappedLineList
+{
+    public:
+        MappedLineList() = default;
+
+        MappedLineList(MappedLineList&&) noexcept = default;
+        MappedLineList& operator=(MappedLineList&&) noexcept = default;
+
+        [[nodiscard]] SingleLinkedList<std::string_view>& GetLines() noexcept
+        {
+            return lines_;
+        }
+
+        [[nodiscard]] const SingleLinkedList<std::string_view>& GetLines() const noexcept
+        {
+            return lines_;
+        }
+
+        [[nodiscard]] const MappedFile& GetFile() const noexcept
+        {
+            return file_;
+        }
+
+    private:
+        friend MappedLineList LoadMappedLines(const std::string& path);
+
+        // Отображение объявлено первым: члены разрушаются в обратном порядке, и список освобождается раньше
+        MappedFile file_;
+        SingleLinkedList<std::string_view> lines_;
+};
+
+/*
+ * Отображает файл path в память и строит список его строк без копирования данных
+ * Разделитель — '\n'; он в строки не входит. Последняя строка без завершающего '\n' тоже попадает в список
+ * Границы строк ищутся через memchr, который в стандартной библиотеке векторизован
+ * При ошибке открытия или отображения файла выбрасывает std::system_error
+ */
+inline MappedLineList LoadMappedLines(const std::string& path)
+{
+    MappedLineList result;
+    result.file_ = MappedFile(path);
+
+    const char* data = result.file_.data();
+    const char* const end = data + result.file_.size();
+    auto last = result.lines_.before_begin();
+
+    while(data != end)
+    {
+        const char* line_end = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+
+        if(line_end == nullptr)
+        {
+            line_end = end;
+        }
+
+        last = result.lines_.InsertAfter(last, std::string_view(data, static_cast<size_t>(line_end - data)));
+        data = line_end == end ? end : line_end + 1;
+    }
+
+    return result;
+}
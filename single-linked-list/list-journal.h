@@ -0,0 +1,787 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "list-codec.h"
+#include "single-linked-list.h"
+
+struct ListJournalOptions
+{
+    // Количество записей, после накопления которых журнал сбрасывается на диск одним fsync (group commit)
+    size_t group_commit_records = 64;
+};
+
+/*
+ * Журнал изменений списка, обеспечивающий его сохранность при аварийном завершении
+ * Вставки и удаления записываются в конец файла журнала <path>.log.<поколение> и сбрасываются
+ * на диск пакетами. Элементы в записях обозначаются постоянными номерами, поэтому запись
+ * не требует вычисления позиции элемента
+ * Уплотнение (StartCompaction) в фоновом потоке записывает снимок <path>.snap и удаляет журнал,
+ * который им покрыт. Восстановление загружает снимок и повторяет журналы следующих поколений
+ * Перестановки и обмен содержимым нельзя выразить записями журнала, поэтому после них
+ * ближайший Commit() синхронно записывает новый снимок
+ * Записи транзакции списка попадают в журнал только после её подтверждения, а при откате отбрасываются
+ * Журнал должен быть уничтожен раньше списка
+ */
+template <typename Type>
+class ListJournal : public SingleLinkedListObserver<Type>
+{
+    public:
+        // Восстанавливает в пустой список list состояние из снимка и журналов по пути path
+        // и начинает журналировать его изменения
+        ListJournal(std::string path, SingleLinkedList<Type>& list, ListJournalOptions options = {})
+            : path_(std::move(path)), list_(list), options_(options)
+        {
+            assert(list_.IsEmpty() && list_.GetErasedCount() == 0);
+            assert(list_.GetObserver() == nullptr);
+
+            Recover();
+            list_.SetObserver(this);
+        }
+
+        ListJournal(const ListJournal&) = delete;
+        ListJournal& operator=(const ListJournal&) = delete;
+
+        ~ListJournal()
+        {
+            list_.SetObserver(nullptr);
+
+            try
+            {
+                Commit();
+                WaitForCompaction();
+            }
+            catch(...)
+            {
+            }
+
+            if(log_fd_ != -1)
+            {
+                ::close(log_fd_);
+            }
+        }
+
+        // Записывает накопленные записи и дожидается их попадания на диск
+        // Во время транзакции списка записываются только записи, сделанные до её начала, а снимок откладывается
+        // Выбрасывает исключение, если предыдущая запись на диск завершилась ошибкой
+        void Commit()
+        {
+            RethrowError();
+
+            if(transaction_start_)
+            {
+                Flush();
+            }
+            else if(needs_snapshot_)
+            {
+                StartCompaction();
+                WaitForCompaction();
+            }
+            else
+            {
+                Flush();
+            }
+        }
+
+        /*
+         * Начинает уплотнение: текущий журнал закрывается, новые записи идут в журнал следующего поколения,
+         * а снимок списка записывается в фоновом потоке, после чего покрытый им журнал удаляется
+         * Копирование значений в снимок выполняется в вызывающем потоке
+         * После перестановки элементы получают новые номера, которых нет ни в прежнем снимке, ни в журналах.
+         * Поэтому такой снимок записывается синхронно и журнал следующего поколения открывается только
+         * после его переименования: иначе сбой до переименования оставил бы журнал, который нельзя повторить
+         * Нельзя вызывать во время транзакции списка
+         */
+        void StartCompaction()
+        {
+            assert(!transaction_start_);
+
+            WaitForCompaction();
+
+            if(needs_snapshot_)
+            {
+                std::vector<std::pair<std::uint64_t, Type>> entries = CaptureSnapshot();
+                const std::uint64_t covered_generation = generation_;
+
+                WriteSnapshot(entries, generation_ + 1, next_id_);
+                buffer_.clear();
+                pending_records_ = 0;
+                needs_snapshot_ = false;
+                OpenLog(generation_ + 1, 0);
+                RemoveFile(LogPath(covered_generation));
+
+                return;
+            }
+
+            Flush();
+
+            std::vector<std::pair<std::uint64_t, Type>> entries = CaptureSnapshot();
+            const std::uint64_t covered_generation = generation_;
+
+            OpenLog(generation_ + 1, 0);
+
+            compaction_ = std::thread([this, entries = std::move(entries), covered_generation,
+                                       generation = generation_, next_id = next_id_]
+            {
+                try
+                {
+                    WriteSnapshot(entries, generation, next_id);
+                    RemoveFile(LogPath(covered_generation));
+                }
+                catch(...)
+                {
+                    compaction_error_ = std::current_exception();
+                }
+            });
+        }
+
+        // Дожидается окончания фонового уплотнения и выбрасывает его ошибку, если она была
+        void WaitForCompaction()
+        {
+            if(compaction_.joinable())
+            {
+                compaction_.join();
+            }
+
+            if(compaction_error_)
+            {
+                std::exception_ptr error = std::exchange(compaction_error_, nullptr);
+                std::rethrow_exception(error);
+            }
+        }
+
+        void OnInsert(const void* pos, const void* element, const Type& value) noexcept override
+        {
+            if(needs_snapshot_)
+            {
+                return;
+            }
+
+            try
+            {
+                std::uint64_t pos_id = 0;
+
+                if(pos != nullptr)
+                {
+                    const auto it = node_ids_.find(pos);
+
+                    if(it == node_ids_.end())
+                    {
+                        needs_snapshot_ = true;
+                        return;
+                    }
+
+                    pos_id = it->second;
+                }
+
+                const std::uint64_t id = next_id_++;
+                node_ids_[element] = id;
+
+                std::string payload(1, static_cast<char>(RecordType::Insert));
+                ListCodec<std::uint64_t>::Encode(pos_id, payload);
+                ListCodec<std::uint64_t>::Encode(id, payload);
+                ListCodec<Type>::Encode(value, payload);
+                AppendRecord(payload);
+            }
+            catch(...)
+            {
+                needs_snapshot_ = true;
+            }
+        }
+
+        void OnErase(const void* element) noexcept override
+        {
+            if(needs_snapshot_)
+            {
+                return;
+            }
+
+            try
+            {
+                const auto it = node_ids_.find(element);
+
+                if(it == node_ids_.end())
+                {
+                    needs_snapshot_ = true;
+                    return;
+                }
+
+                std::string payload(1, static_cast<char>(RecordType::Erase));
+                ListCodec<std::uint64_t>::Encode(it->second, payload);
+                node_ids_.erase(it);
+                AppendRecord(payload);
+            }
+            catch(...)
+            {
+                needs_snapshot_ = true;
+            }
+        }
+
+        void OnClear() noexcept override
+        {
+            node_ids_.clear();
+
+            if(needs_snapshot_)
+            {
+                return;
+            }
+
+            try
+            {
+                AppendRecord(std::string(1, static_cast<char>(RecordType::Clear)));
+            }
+            catch(...)
+            {
+                needs_snapshot_ = true;
+            }
+        }
+
+        void OnReset() noexcept override
+        {
+            needs_snapshot_ = true;
+        }
+
+        // Записи транзакции накапливаются в конце буфера и не сбрасываются на диск до её подтверждения
+        void OnTransactionBegin() noexcept override
+        {
+            transaction_start_ = buffer_.size();
+            transaction_records_ = 0;
+        }
+
+        void OnTransactionCommit() noexcept override
+        {
+            transaction_start_.reset();
+            pending_records_ += transaction_records_;
+            FlushIfFull();
+        }
+
+        // Откат сопровождается OnReset(), поэтому следующий Commit() запишет снимок восстановленного списка
+        void OnTransactionRollback() noexcept override
+        {
+            if(transaction_start_)
+            {
+                buffer_.resize(*transaction_start_);
+                transaction_start_.reset();
+            }
+        }
+
+    private:
+        using Iterator = typename SingleLinkedList<Type>::Iterator;
+
+        enum class RecordType : char
+        {
+            Insert = 1,
+            Erase = 2,
+            Clear = 3
+        };
+
+        static constexpr char kSnapshotMagic[8] = {'S', 'L', 'L', 'S', 'N', 'A', 'P', '1'};
+
+        std::string LogPath(std::uint64_t generation) const
+        {
+            return path_ + ".log." + std::to_string(generation);
+        }
+
+        std::string SnapshotPath() const
+        {
+            return path_ + ".snap";
+        }
+
+        static std::uint32_t Checksum(const char* data, size_t size) noexcept
+        {
+            // FNV-1a
+            std::uint32_t hash = 2166136261u;
+
+            for(size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+            }
+
+            return hash;
+        }
+
+        [[noreturn]] static void ThrowSystemError(const std::string& what)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        // Читает файл целиком. Возвращает пустое значение, если файла нет
+        static std::optional<std::string> ReadFile(const std::string& path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+            if(fd == -1)
+            {
+                if(errno == ENOENT)
+                {
+                    return std::nullopt;
+                }
+
+                ThrowSystemError("open " + path);
+            }
+
+            std::string content;
+            char chunk[1 << 16];
+
+            while(true)
+            {
+                const ssize_t count = ::read(fd, chunk, sizeof(chunk));
+
+                if(count == -1 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                if(count == -1)
+                {
+                    const int error = errno;
+                    ::close(fd);
+                    errno = error;
+                    ThrowSystemError("read " + path);
+                }
+
+                if(count == 0)
+                {
+                    break;
+                }
+
+                content.append(chunk, static_cast<size_t>(count));
+            }
+
+            ::close(fd);
+
+            return content;
+        }
+
+        static void WriteAll(int fd, const char* data, size_t size, const std::string& path)
+        {
+            while(size != 0)
+            {
+                const ssize_t count = ::write(fd, data, size);
+
+                if(count == -1)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    ThrowSystemError("write " + path);
+                }
+
+                data += count;
+                size -= static_cast<size_t>(count);
+            }
+        }
+
+        static void RemoveFile(const std::string& path)
+        {
+            if(::unlink(path.c_str()) == -1 && errno != ENOENT)
+            {
+                ThrowSystemError("unlink " + path);
+            }
+        }
+
+        // Сбрасывает на диск каталог, чтобы переименование и создание файлов пережили сбой
+        void SyncDirectory() const
+        {
+            const size_t slash = path_.rfind('/');
+            const std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+            const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+            if(fd == -1)
+            {
+                ThrowSystemError("open " + directory);
+            }
+
+            const int result = ::fsync(fd);
+            ::close(fd);
+
+            if(result == -1)
+            {
+                ThrowSystemError("fsync " + directory);
+            }
+        }
+
+        void Recover()
+        {
+            std::unordered_map<std::uint64_t, Iterator> nodes;
+            const std::uint64_t snapshot_generation = LoadSnapshot(nodes);
+            std::uint64_t generation = snapshot_generation;
+            size_t valid_length = 0;
+
+            for(std::uint64_t log_generation = snapshot_generation; ; ++log_generation)
+            {
+                const std::optional<size_t> length = ReplayLog(log_generation, nodes);
+
+                if(!length)
+                {
+                    break;
+                }
+
+                generation = log_generation;
+                valid_length = *length;
+            }
+
+            // Удалённые при повторе элементы были помечены логически
+            list_.Compact();
+
+            for(auto& [id, it] : nodes)
+            {
+                node_ids_.emplace(&*it, id);
+            }
+
+            // Журнал, оставшийся от уплотнения, прерванного после записи снимка
+            if(snapshot_generation != 0)
+            {
+                RemoveFile(LogPath(snapshot_generation - 1));
+            }
+
+            // Последний журнал продолжается с конца последней целой записи
+            OpenLog(generation, valid_length);
+        }
+
+        // Загружает снимок в список. Возвращает поколение первого журнала, не покрытого снимком
+        std::uint64_t LoadSnapshot(std::unordered_map<std::uint64_t, Iterator>& nodes)
+        {
+            const std::optional<std::string> content = ReadFile(SnapshotPath());
+
+            if(!content)
+            {
+                return 0;
+            }
+
+            const char* data = content->data();
+            const char* end = data + content->size();
+            std::uint64_t generation = 0;
+            std::uint64_t count = 0;
+
+            if(content->size() < sizeof(kSnapshotMagic) || std::memcmp(data, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0)
+            {
+                throw std::runtime_error("corrupted list snapshot " + SnapshotPath());
+            }
+
+            data += sizeof(kSnapshotMagic);
+
+            if(!ListCodec<std::uint64_t>::Decode(data, end, generation)
+               || !ListCodec<std::uint64_t>::Decode(data, end, next_id_)
+               || !ListCodec<std::uint64_t>::Decode(data, end, count))
+            {
+                throw std::runtime_error("corrupted list snapshot " + SnapshotPath());
+            }
+
+            Iterator last = list_.before_begin();
+
+            for(std::uint64_t i = 0; i < count; ++i)
+            {
+                std::uint64_t id = 0;
+                Type value{};
+
+                if(!ListCodec<std::uint64_t>::Decode(data, end, id) || !ListCodec<Type>::Decode(data, end, value))
+                {
+                    throw std::runtime_error("corrupted list snapshot " + SnapshotPath());
+                }
+
+                last = list_.InsertAfter(last, value);
+                nodes.emplace(id, last);
+            }
+
+            return generation;
+        }
+
+        // Повторяет записи журнала поколения generation. Возвращает длину целой части журнала
+        // либо пустое значение, если журнала нет. Недописанная последняя запись отбрасывается
+        std::optional<size_t> ReplayLog(std::uint64_t generation, std::unordered_map<std::uint64_t, Iterator>& nodes)
+        {
+            const std::optional<std::string> content = ReadFile(LogPath(generation));
+
+            if(!content)
+            {
+                return std::nullopt;
+            }
+
+            const char* begin = content->data();
+            const char* data = begin;
+            const char* end = begin + content->size();
+
+            while(true)
+            {
+                const char* record = data;
+                std::uint32_t length = 0;
+                std::uint32_t checksum = 0;
+
+                if(!ListCodec<std::uint32_t>::Decode(data, end, length)
+                   || !ListCodec<std::uint32_t>::Decode(data, end, checksum)
+                   || static_cast<size_t>(end - data) < length
+                   || length == 0
+                   || Checksum(data, length) != checksum)
+                {
+                    return static_cast<size_t>(record - begin);
+                }
+
+                const char* payload_end = data + length;
+                const auto type = static_cast<RecordType>(*data++);
+
+                if(type == RecordType::Insert)
+                {
+                    std::uint64_t pos_id = 0;
+                    std::uint64_t id = 0;
+                    Type value{};
+
+                    if(!ListCodec<std::uint64_t>::Decode(data, payload_end, pos_id)
+                       || !ListCodec<std::uint64_t>::Decode(data, payload_end, id)
+                       || !ListCodec<Type>::Decode(data, payload_end, value)
+                       || (pos_id != 0 && nodes.count(pos_id) == 0))
+                    {
+                        throw std::runtime_error("corrupted list journal " + LogPath(generation));
+                    }
+
+                    const Iterator pos = pos_id == 0 ? list_.before_begin() : nodes.at(pos_id);
+                    nodes[id] = list_.InsertAfter(pos, value);
+                    next_id_ = std::max(next_id_, id + 1);
+                }
+                else if(type == RecordType::Erase)
+                {
+                    std::uint64_t id = 0;
+
+                    if(!ListCodec<std::uint64_t>::Decode(data, payload_end, id) || nodes.count(id) == 0)
+                    {
+                        throw std::runtime_error("corrupted list journal " + LogPath(generation));
+                    }
+
+                    // Логическое удаление не требует предыдущего элемента
+                    list_.MarkErased(nodes.at(id));
+                    nodes.erase(id);
+                }
+                else if(type == RecordType::Clear)
+                {
+                    list_.Clear();
+                    nodes.clear();
+                }
+                else
+                {
+                    throw std::runtime_error("corrupted list journal " + LogPath(generation));
+                }
+
+                data = payload_end;
+            }
+        }
+
+        // Делает журнал поколения generation текущим, обрезая его до length байт
+        void OpenLog(std::uint64_t generation, size_t length)
+        {
+            const std::string path = LogPath(generation);
+            const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+            if(fd == -1)
+            {
+                ThrowSystemError("open " + path);
+            }
+
+            if(::ftruncate(fd, static_cast<off_t>(length)) == -1 || ::lseek(fd, 0, SEEK_END) == -1)
+            {
+                const int error = errno;
+                ::close(fd);
+                errno = error;
+                ThrowSystemError("truncate " + path);
+            }
+
+            if(log_fd_ != -1)
+            {
+                ::close(log_fd_);
+            }
+
+            log_fd_ = fd;
+            generation_ = generation;
+            SyncDirectory();
+        }
+
+        void AppendRecord(const std::string& payload)
+        {
+            const std::uint32_t length = static_cast<std::uint32_t>(payload.size());
+            ListCodec<std::uint32_t>::Encode(length, buffer_);
+            ListCodec<std::uint32_t>::Encode(Checksum(payload.data(), payload.size()), buffer_);
+            buffer_.append(payload);
+
+            if(transaction_start_)
+            {
+                ++transaction_records_;
+            }
+            else
+            {
+                ++pending_records_;
+                FlushIfFull();
+            }
+        }
+
+        void FlushIfFull() noexcept
+        {
+            if(pending_records_ >= options_.group_commit_records)
+            {
+                try
+                {
+                    Flush();
+                }
+                catch(...)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+        }
+
+        // Записывает накопленные записи, кроме записей незавершённой транзакции, одним write и одним fdatasync
+        void Flush()
+        {
+            const size_t size = transaction_start_ ? *transaction_start_ : buffer_.size();
+
+            if(size == 0)
+            {
+                return;
+            }
+
+            WriteAll(log_fd_, buffer_.data(), size, LogPath(generation_));
+
+            if(::fdatasync(log_fd_) == -1)
+            {
+                ThrowSystemError("fdatasync " + LogPath(generation_));
+            }
+
+            buffer_.erase(0, size);
+            pending_records_ = 0;
+
+            if(transaction_start_)
+            {
+                transaction_start_ = 0;
+            }
+        }
+
+        void RethrowError()
+        {
+            if(error_)
+            {
+                std::exception_ptr error = std::exchange(error_, nullptr);
+                std::rethrow_exception(error);
+            }
+        }
+
+        // Копирует элементы списка вместе с их номерами. После перестановок номера назначаются заново
+        std::vector<std::pair<std::uint64_t, Type>> CaptureSnapshot()
+        {
+            std::vector<std::pair<std::uint64_t, Type>> entries;
+            entries.reserve(list_.GetSize());
+
+            if(needs_snapshot_)
+            {
+                node_ids_.clear();
+            }
+
+            for(const Type& value : list_)
+            {
+                auto [it, inserted] = node_ids_.emplace(&value, next_id_);
+
+                if(inserted)
+                {
+                    ++next_id_;
+                }
+
+                entries.emplace_back(it->second, value);
+            }
+
+            return entries;
+        }
+
+        // Записывает снимок во временный файл и атомарно заменяет им прежний
+        void WriteSnapshot(const std::vector<std::pair<std::uint64_t, Type>>& entries, std::uint64_t generation, std::uint64_t next_id) const
+        {
+            const std::string path = SnapshotPath();
+            const std::string tmp_path = path + ".tmp";
+            const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+            if(fd == -1)
+            {
+                ThrowSystemError("open " + tmp_path);
+            }
+
+            try
+            {
+                std::string chunk(kSnapshotMagic, sizeof(kSnapshotMagic));
+                ListCodec<std::uint64_t>::Encode(generation, chunk);
+                ListCodec<std::uint64_t>::Encode(next_id, chunk);
+                ListCodec<std::uint64_t>::Encode(entries.size(), chunk);
+
+                for(const auto& [id, value] : entries)
+                {
+                    ListCodec<std::uint64_t>::Encode(id, chunk);
+                    ListCodec<Type>::Encode(value, chunk);
+
+                    if(chunk.size() >= (1u << 20))
+                    {
+                        WriteAll(fd, chunk.data(), chunk.size(), tmp_path);
+                        chunk.clear();
+                    }
+                }
+
+                WriteAll(fd, chunk.data(), chunk.size(), tmp_path);
+
+                if(::fsync(fd) == -1)
+                {
+                    ThrowSystemError("fsync " + tmp_path);
+                }
+            }
+            catch(...)
+            {
+                ::close(fd);
+                throw;
+            }
+
+            ::close(fd);
+
+            if(::rename(tmp_path.c_str(), path.c_str()) == -1)
+            {
+                ThrowSystemError("rename " + tmp_path);
+            }
+
+            SyncDirectory();
+        }
+
+        std::string path_;
+        SingleLinkedList<Type>& list_;
+        ListJournalOptions options_;
+
+        int log_fd_ = -1;
+        std::uint64_t generation_ = 0;
+        // Номер, который получит следующий вставленный элемент. 0 обозначает позицию перед первым элементом
+        std::uint64_t next_id_ = 1;
+        // Номера элементов списка по их ключам (адресам значений)
+        std::unordered_map<const void*, std::uint64_t> node_ids_;
+
+        // Записи, ожидающие сброса на диск
+        std::string buffer_;
+        size_t pending_records_ = 0;
+        // Начало записей незавершённой транзакции списка в buffer_ и их количество
+        std::optional<size_t> transaction_start_;
+        size_t transaction_records_ = 0;
+        // Журнал больше не описывает список: до следующего снимка записи не ведутся
+        bool needs_snapshot_ = false;
+        std::exception_ptr error_;
+
+        std::thread compaction_;
+        std::exception_ptr compaction_error_;
+};
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "list-codec.h"
+#include "list-executor.h"
+#include "single-linked-list.h"
+
+struct ListStreamOptions
+{
+    // Количество элементов в одном блоке файла
+    size_t chunk_elements = 4096;
+    // Сколько прочитанных блоков может одновременно ожидать разбора; 0 — по числу потоков исполнителя
+    size_t max_chunks_in_flight = 0;
+};
+
+/*
+ * Потоковый формат списка: заголовок, затем блоки, в каждом — количество элементов (uint64_t),
+ * размер данных (uint64_t) и сами элементы в представлении ListCodec. Завершает файл пустой блок
+ * Блоки разбираются независимо друг от друга, поэтому загрузку можно распараллелить
+ */
+namespace list_stream_detail
+{
+    inline constexpr char kMagic[8] = {'S', 'L', 'L', 'S', 'T', 'R', 'M', '1'};
+
+    inline void WriteAll(int fd, const char* data, size_t size)
+    {
+        while(size != 0)
+        {
+            const ssize_t written = ::write(fd, data, size);
+
+            if(written == -1)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // Читает ровно size байт; при преждевременном конце файла выбрасывает исключение
+    inline void ReadExact(int fd, char* data, size_t size)
+    {
+        while(size != 0)
+        {
+            const ssize_t count = ::read(fd, data, size);
+
+            if(count == -1)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::generic_category(), "read");
+            }
+
+            if(count == 0)
+            {
+                throw std::runtime_error("truncated list stream");
+            }
+
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+    }
+
+    /*
+     * Читает данные блока размером size, записанным в заголовке. Размер проверяется до выделения памяти:
+     * у обычного файла — по оставшейся части файла, у канала и сокета данные читаются частями,
+     * и память растёт только вместе с прочитанным. Повреждённый размер даёт ошибку, а не огромное выделение
+     */
+    inline std::string ReadPayload(int fd, std::uint64_t size)
+    {
+        constexpr size_t kReadStep = size_t{1} << 20;
+
+        struct stat info;
+
+        if(::fstat(fd, &info) == -1)
+        {
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        }
+
+        if(S_ISREG(info.st_mode))
+        {
+            const off_t position = ::lseek(fd, 0, SEEK_CUR);
+
+            if(position != -1 && (position > info.st_size || size > static_cast<std::uint64_t>(info.st_size - position)))
+            {
+                throw std::runtime_error("corrupted list stream");
+            }
+        }
+
+        if(size > std::string().max_size())
+        {
+            throw std::runtime_error("corrupted list stream");
+        }
+
+        std::string payload;
+
+        while(payload.size() != size)
+        {
+            const size_t offset = payload.size();
+            payload.resize(offset + static_cast<size_t>(std::min<std::uint64_t>(size - offset, kReadStep)));
+            ReadExact(fd, payload.data() + offset, payload.size() - offset);
+        }
+
+        return payload;
+    }
+
+    // Разобранный блок: готовая цепочка узлов и итератор на её последний узел
+    template <typename Type>
+    struct Segment
+    {
+        SingleLinkedList<Type> list;
+        typename SingleLinkedList<Type>::ConstIterator last;
+    };
+
+    // Разбирает count элементов из [data, end) в готовую цепочку узлов
+    template <typename Type>
+    Segment<Type> DecodeChunk(const char* data, const char* end, std::uint64_t count)
+    {
+        Segment<Type> segment;
+        segment.last = segment.list.cbefore_begin();
+
+        for(std::uint64_t i = 0; i < count; ++i)
+        {
+            Type value{};
+
+            if(!ListCodec<Type>::Decode(data, end, value))
+            {
+                throw std::runtime_error("corrupted list stream chunk");
+            }
+
+            segment.last = segment.list.InsertAfter(segment.last, std::move(value));
+        }
+
+        if(data != end)
+        {
+            throw std::runtime_error("corrupted list stream chunk");
+        }
+
+        return segment;
+    }
+
+    // Записывает в chunk блок из не более limit элементов, начиная с it, и сдвигает it. Возвращает число элементов
+    template <typename Iterator>
+    std::uint64_t EncodeChunk(Iterator& it, Iterator end, size_t limit, std::string& chunk)
+    {
+        chunk.assign(2 * sizeof(std::uint64_t), '\0');
+        std::uint64_t count = 0;
+
+        for(; it != end && count < limit; ++it, ++count)
+        {
+            ListCodec<typename std::iterator_traits<Iterator>::value_type>::Encode(*it, chunk);
+        }
+
+        const std::uint64_t size = chunk.size() - 2 * sizeof(std::uint64_t);
+        std::memcpy(chunk.data(), &count, sizeof(count));
+        std::memcpy(chunk.data() + sizeof(count), &size, sizeof(size));
+
+        return count;
+    }
+
+    // Разбирает заголовок блока
+    inline void DecodeChunkHeader(const char* header, std::uint64_t& count, std::uint64_t& size) noexcept
+    {
+        std::memcpy(&count, header, sizeof(count));
+        std::memcpy(&size, header + sizeof(count), sizeof(size));
+    }
+
+    // Разбирает поток целиком находящийся в памяти
+    template <typename Type>
+    SingleLinkedList<Type> DecodeStream(const char* data, const char* end)
+    {
+        constexpr size_t kHeaderSize = 2 * sizeof(std::uint64_t);
+
+        if(static_cast<size_t>(end - data) < sizeof(kMagic) || std::memcmp(data, kMagic, sizeof(kMagic)) != 0)
+        {
+            throw std::runtime_error("not a list stream");
+        }
+
+        data += sizeof(kMagic);
+
+        SingleLinkedList<Type> result;
+        auto last = result.cbefore_begin();
+
+        while(true)
+        {
+            if(static_cast<size_t>(end - data) < kHeaderSize)
+            {
+                throw std::runtime_error("truncated list stream");
+            }
+
+            std::uint64_t count = 0;
+            std::uint64_t size = 0;
+            DecodeChunkHeader(data, count, size);
+            data += kHeaderSize;
+
+            if(count == 0)
+            {
+                return result;
+            }
+
+            if(static_cast<std::uint64_t>(end - data) < size)
+            {
+                throw std::runtime_error("truncated list stream");
+            }
+
+            Segment<Type> segment = DecodeChunk<Type>(data, data + size, count);
+            last = result.SpliceAfter(last, std::move(segment.list), segment.last);
+            data += size;
+        }
+    }
+}
+
+// Записывает список в fd в потоковом формате блоками по options.chunk_elements элементов
+template <typename Type>
+void SaveListStream(int fd, const SingleLinkedList<Type>& list, ListStreamOptions options = {})
+{
+    assert(options.chunk_elements != 0);
+
+    list_stream_detail::WriteAll(fd, list_stream_detail::kMagic, sizeof(list_stream_detail::kMagic));
+
+    std::string chunk;
+    auto it = list.begin();
+
+    while(true)
+    {
+        const std::uint64_t count = list_stream_detail::EncodeChunk(it, list.end(), options.chunk_elements, chunk);
+        list_stream_detail::WriteAll(fd, chunk.data(), chunk.size());
+
+        if(count == 0)
+        {
+            return;
+        }
+    }
+}
+
+/*
+ * Загружает список из fd, записанный SaveListStream, конвейером из перекрывающихся стадий:
+ * вызывающий поток читает очередной блок, пока задачи на executor разбирают прочитанные ранее
+ * и строят из них готовые цепочки узлов. Цепочки подвешиваются к результату в порядке блоков
+ * за O(1) каждая, поэтому последовательная часть загрузки сводится к чтению
+ * Число блоков в обработке ограничено options.max_chunks_in_flight, что ограничивает и память
+ * Вызывающий поток ждёт задачи разбора, поэтому не должен быть единственным рабочим потоком executor
+ * (проверяется assert)
+ * При ошибке чтения выбрасывает std::system_error, при повреждённых данных — std::runtime_error
+ */
+template <typename Type>
+SingleLinkedList<Type> LoadListStream(int fd, ListStreamOptions options = {}, ListExecutor& executor = DefaultListExecutor())
+{
+    using list_stream_detail::Segment;
+
+    // Задачи разбора попали бы в очередь того же потока, который ждёт их результата
+    assert(!(executor.IsWorkerThread() && executor.GetConcurrency() == 1));
+
+    char magic[sizeof(list_stream_detail::kMagic)];
+    list_stream_detail::ReadExact(fd, magic, sizeof(magic));
+
+    if(std::memcmp(magic, list_stream_detail::kMagic, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error("not a list stream");
+    }
+
+    const size_t max_in_flight = options.max_chunks_in_flight != 0
+                                     ? options.max_chunks_in_flight
+                                     : executor.GetConcurrency() + 1;
+
+    SingleLinkedList<Type> result;
+    auto last = result.cbefore_begin();
+    std::deque<std::future<Segment<Type>>> pending;
+
+    // Подвешивает к результату самый старый разобранный блок
+    auto link_oldest = [&]()
+    {
+        Segment<Type> segment = pending.front().get();
+        pending.pop_front();
+        last = result.SpliceAfter(last, std::move(segment.list), segment.last);
+    };
+
+    while(true)
+    {
+        char header[2 * sizeof(std::uint64_t)];
+        list_stream_detail::ReadExact(fd, header, sizeof(header));
+
+        std::uint64_t count = 0;
+        std::uint64_t size = 0;
+        list_stream_detail::DecodeChunkHeader(header, count, size);
+
+        if(count == 0)
+        {
+            break;
+        }
+
+        std::string payload = list_stream_detail::ReadPayload(fd, size);
+
+        if(pending.size() == max_in_flight)
+        {
+            link_oldest();
+        }
+
+        pending.push_back(Submit(executor, [payload = std::move(payload), count]()
+        {
+            return list_stream_detail::DecodeChunk<Type>(payload.data(), payload.data() + payload.size(), count);
+        }));
+    }
+
+    while(!pending.empty())
+    {
+        link_oldest();
+    }
+
+    return result;
+}
@@ -1,6 +1,33 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
 
+#include "list-async-io.h"
+#include "list-diff.h"
+#include "list-io.h"
+#include "lazy-list.h"
+#include "list-journal.h"
+#include "list-stream.h"
+#include "ring-list.h"
 #include "single-linked-list.h"
+#include "skip-list-map.h"
+#include "split-ordered-map.h"
+#include "spsc-queue.h"
 
 // Эта функция проверяет работу класса SingleLinkedList
 void Test() {
@@ -145,6 +172,1679 @@ void Test() {
     }
 }
 
+// Эта функция проверяет частичную сортировку и выбор n-го элемента
+void TestSelection() {
+    // Псевдослучайные значения с повторами
+    std::vector<int> values;
+    unsigned state = 12345;
+    for (int i = 0; i < 200; ++i) {
+        state = state * 1103515245u + 12345u;
+        values.push_back(static_cast<int>((state >> 16) % 50));
+    }
+    const auto make_list = [&values] {
+        SingleLinkedList<int> lst;
+        for (auto it = values.rbegin(); it != values.rend(); ++it) {
+            lst.PushFront(*it);
+        }
+        return lst;
+    };
+    std::vector<int> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    // Частичная сортировка
+    {
+        for (size_t k : {0u, 1u, 10u, 199u, 200u, 500u}) {
+            SingleLinkedList<int> lst = make_list();
+            lst.PartialSort(k);
+            std::vector<int> result(lst.begin(), lst.end());
+            assert(lst.GetSize() == values.size());
+            const size_t prefix = std::min(k, values.size());
+            assert(std::equal(sorted.begin(), sorted.begin() + prefix, result.begin()));
+            std::sort(result.begin(), result.end());
+            assert(result == sorted);
+        }
+
+        SingleLinkedList<int> lst{5, 3, 8, 1, 9, 2};
+        lst.PartialSort(3, std::greater<int>{});
+        auto it = lst.begin();
+        assert(*it++ == 9 && *it++ == 8 && *it++ == 5);
+    }
+
+    // Выбор n-го элемента
+    {
+        for (size_t k : {0u, 1u, 57u, 100u, 199u}) {
+            SingleLinkedList<int> lst = make_list();
+            lst.NthElement(k);
+            std::vector<int> result(lst.begin(), lst.end());
+            assert(result[k] == sorted[k]);
+            assert(std::all_of(result.begin(), result.begin() + k, [&](int v) { return v <= result[k]; }));
+            assert(std::all_of(result.begin() + k, result.end(), [&](int v) { return v >= result[k]; }));
+            std::sort(result.begin(), result.end());
+            assert(result == sorted);
+        }
+    }
+}
+
+// Эта функция проверяет работу кольцевого списка
+void TestRing() {
+    // Поворот кольца
+    {
+        RingList<int> ring{1, 2, 3};
+        assert(ring.Current() == 1);
+        ring.Advance();
+        assert(ring.Current() == 2);
+        assert((ring == RingList<int>{2, 3, 1}));
+        ring.Advance(4);
+        assert(ring.Current() == 3);
+        assert((ring == RingList<int>{3, 1, 2}));
+    }
+
+    // Вставка в конец и в начало, удаление текущего
+    {
+        RingList<int> ring;
+        assert(ring.IsEmpty() && ring.begin() == ring.end());
+        ring.PushBack(1);
+        ring.PushBack(2);
+        ring.PushFront(0);
+        assert((ring == RingList<int>{0, 1, 2}));
+        ring.PopFront();
+        assert((ring == RingList<int>{1, 2}));
+        ring.PopFront();
+        ring.PopFront();
+        assert(ring.IsEmpty() && ring.begin() == ring.end());
+    }
+
+    // Вставка и удаление вокруг итератора, поворот к итератору
+    {
+        RingList<int> ring{1, 2, 3, 4};
+        auto it = ring.begin();
+        ++it;
+        auto inserted = ring.InsertAfter(it, 25);
+        assert((ring == RingList<int>{1, 2, 25, 3, 4}));
+        ring.RotateTo(inserted);
+        assert(ring.Current() == 25);
+        assert((ring == RingList<int>{25, 3, 4, 1, 2}));
+        auto next = ring.Erase(ring.begin());
+        assert(*next == 3);
+        assert((ring == RingList<int>{3, 4, 1, 2}));
+        ring.EraseAfter(ring.begin());
+        assert((ring == RingList<int>{3, 1, 2}));
+        const RingList<int> copy = ring;
+        assert(copy == ring && copy.GetSize() == 3u);
+    }
+
+    // Как и у списка, следующая за before_begin() позиция — begin()
+    {
+        RingList<int> ring{1, 2, 3};
+        assert(++ring.before_begin() == ring.begin());
+        assert(*std::next(ring.cbefore_begin()) == 1);
+        assert(std::distance(ring.begin(), ring.end()) == 3);
+    }
+
+    // Удаление элементов при обходе посещает каждый элемент один раз
+    {
+        RingList<int> ring{1, 2, 3, 4, 5};
+        std::vector<int> visited;
+        auto prev = ring.before_begin();
+        for (auto it = ring.begin(); it != ring.end();) {
+            visited.push_back(*it);
+            if (*it % 2 != 0) {
+                it = ring.EraseAfter(prev);
+            } else {
+                prev = it++;
+            }
+        }
+        assert((visited == std::vector<int>{1, 2, 3, 4, 5}));
+        assert((ring == RingList<int>{2, 4}));
+        assert(ring.Current() == 2);
+    }
+
+    // Вставка между итератором и его предыдущим элементом не сбивает поворот и удаление
+    {
+        RingList<int> ring{1, 2, 3};
+        auto it = ++ring.begin();
+        ring.InsertAfter(ring.begin(), 9);
+        ring.RotateTo(it);
+        assert(ring.Current() == 2);
+        assert((ring == RingList<int>{2, 3, 1, 9}));
+    }
+    {
+        RingList<int> ring{1, 2, 3};
+        auto it = ++ring.begin();
+        ring.InsertAfter(ring.begin(), 9);
+        assert(*ring.Erase(it) == 3);
+        assert((ring == RingList<int>{1, 9, 3}));
+    }
+
+    // Вставка после последнего элемента круга добавляет элемент в конец, после before_begin() — в начало
+    {
+        RingList<int> ring{1, 2, 3};
+        auto last = std::next(ring.begin(), 2);
+        ring.InsertAfter(last, 4);
+        assert(ring.Current() == 1);
+        assert((ring == RingList<int>{1, 2, 3, 4}));
+        ring.InsertAfter(ring.before_begin(), 0);
+        assert(ring.Current() == 0);
+        assert((ring == RingList<int>{0, 1, 2, 3, 4}));
+    }
+}
+
+// Эта функция проверяет логическое удаление элементов и уплотнение списка
+void TestTombstones() {
+    // Обход пропускает логически удалённые элементы
+    {
+        SingleLinkedList<int> lst{1, 2, 3, 4, 5};
+        auto second = ++lst.begin();
+        auto third = ++(++lst.begin());
+        lst.MarkErased(lst.begin());
+        lst.MarkErased(third);
+        assert((lst == SingleLinkedList<int>{2, 4, 5}));
+        assert(lst.GetSize() == 3u && lst.GetErasedCount() == 2u);
+        assert(*lst.begin() == 2 && lst.begin() == second);
+
+        // Итератор на удалённый элемент остаётся действительным и продолжает обход
+        auto it = third;
+        assert(*++it == 4);
+
+        const SingleLinkedList<int> copy = lst;
+        assert(copy == lst && copy.GetErasedCount() == 0u);
+    }
+
+    // Удаление и вставка рядом с логически удалёнными элементами
+    {
+        SingleLinkedList<int> lst{1, 2, 3, 4};
+        lst.MarkErased(++lst.begin());
+        const auto after_erased = lst.EraseAfter(lst.cbegin());
+        assert(*after_erased == 4);
+        assert((lst == SingleLinkedList<int>{1, 4}));
+        lst.MarkErased(lst.begin());
+        lst.PopFront();
+        assert(lst.IsEmpty() && lst.begin() == lst.end());
+        lst.InsertAfter(lst.before_begin(), 7);
+        assert((lst == SingleLinkedList<int>{7}));
+    }
+
+    // Уплотнение по порогу
+    {
+        SingleLinkedList<int> lst{1, 2, 3, 4, 5, 6};
+        lst.MarkErased(lst.begin());
+        lst.MarkErased(++(++lst.begin()));
+        assert(lst.Compact(3) == 0u && lst.GetErasedCount() == 2u);
+        lst.MarkErased(++(++(++lst.begin())));
+        assert(lst.Compact(3) == 3u && lst.GetErasedCount() == 0u);
+        assert((lst == SingleLinkedList<int>{2, 3, 5}));
+        assert(lst.Compact() == 0u);
+    }
+
+    // Алгоритмы перевязки учитывают логически удалённые элементы
+    {
+        SingleLinkedList<int> lst{5, 1, 4, 2, 3};
+        lst.MarkErased(++lst.begin());
+        lst.PartialSort(2);
+        assert(*lst.begin() == 2 && *++lst.begin() == 3 && lst.GetSize() == 4u);
+        lst.NthElement(3);
+        assert(*++(++(++lst.begin())) == 5 && lst.GetErasedCount() == 0u);
+    }
+}
+
+// Эта функция проверяет работу устойчивых курсоров
+void TestCursors() {
+    // Курсор переходит на следующий элемент при удалении текущего
+    {
+        SingleLinkedList<int> lst{1, 2, 3, 4};
+        auto cursor = lst.MakeCursor(++lst.begin());
+        assert(*cursor == 2);
+        lst.EraseAfter(lst.cbegin());
+        assert(!cursor.AtEnd() && *cursor == 3);
+        auto copy = cursor;
+        ++copy;
+        assert(*copy == 4 && *cursor == 3);
+        lst.EraseAfter(lst.cbegin());
+        lst.EraseAfter(lst.cbegin());
+        assert(cursor.AtEnd() && copy.AtEnd());
+        assert(cursor.GetIterator() == lst.end());
+    }
+
+    // Уплотнение, очистка и уничтожение списка
+    {
+        SingleLinkedList<int>::Cursor outlived;
+        {
+            SingleLinkedList<int> lst{1, 2, 3, 4};
+            auto cursor = lst.MakeCursor(++lst.begin());
+            lst.MarkErased(++lst.begin());
+            lst.MarkErased(++lst.begin());
+            assert(*cursor == 2);
+            lst.Compact();
+            assert(*cursor == 4 && cursor.GetIterator() == ++lst.begin());
+
+            SingleLinkedList<int> other{7, 8};
+            lst.swap(other);
+            lst.EraseAfter(lst.cbefore_begin());
+            other.EraseAfter(other.cbegin());
+            assert(cursor.AtEnd());
+
+            outlived = other.MakeCursor(other.begin());
+            other.Clear();
+            assert(outlived.AtEnd() && outlived.IsAttached());
+            outlived = other.MakeCursor(other.begin());
+        }
+        assert(!outlived.IsAttached());
+    }
+}
+
+// Эта функция проверяет пакетный поиск ключей
+void TestFindAll() {
+    SingleLinkedList<std::string> lst{"a", "b", "c", "b", "d"};
+    lst.MarkErased(lst.begin());
+    std::vector<SingleLinkedList<std::string>::FindResult> found;
+    lst.FindAll({"d", "a", "b", "x", "d"}, found);
+    assert(found.size() == 5u);
+
+    assert(found[0].position != lst.end() && *found[0].position == "d");
+    assert(found[1].position == lst.end());
+    assert(found[2].position == lst.begin() && found[2].before == lst.before_begin());
+    assert(found[3].position == lst.end());
+    assert(found[4].position == found[0].position);
+
+    lst.EraseAfter(found[0].before);
+    assert((lst == SingleLinkedList<std::string>{"b", "c", "b"}));
+
+    SingleLinkedList<std::string> empty_list;
+    empty_list.FindAll({"a"}, found);
+    assert(found.size() == 1u && found[0].position == empty_list.end());
+}
+
+// Эта функция проверяет удаление дубликатов из неупорядоченного списка
+void TestDedupStable() {
+    {
+        SingleLinkedList<int> lst{3, 1, 3, 2, 1, 1, 4, 2};
+        auto cursor = lst.MakeCursor(++(++lst.begin()));
+        assert(lst.DedupStable() == 4u);
+        assert((lst == SingleLinkedList<int>{3, 1, 2, 4}));
+        assert(lst.GetSize() == 4u);
+        assert(*cursor == 2);
+    }
+    {
+        SingleLinkedList<std::string> lst{"x", "y", "x"};
+        lst.MarkErased(lst.begin());
+        assert(lst.DedupStable() == 0u);
+        assert((lst == SingleLinkedList<std::string>{"y", "x"}));
+
+        SingleLinkedList<std::string> empty_list;
+        assert(empty_list.DedupStable() == 0u);
+    }
+    {
+        // Дубликаты с точностью до регистра первой буквы
+        SingleLinkedList<std::string> lst{"Ab", "ab", "cd", "Cd"};
+        const auto hash = [](const std::string& s) { return std::hash<char>{}(static_cast<char>(s[0] | 0x20)); };
+        const auto equal = [](const std::string& lhs, const std::string& rhs) { return (lhs[0] | 0x20) == (rhs[0] | 0x20); };
+        assert(lst.DedupStable(hash, equal) == 2u);
+        assert((lst == SingleLinkedList<std::string>{"Ab", "cd"}));
+    }
+}
+
+// Эта функция проверяет применение пакета позиционных правок
+void TestApplyEdits() {
+    using List = SingleLinkedList<int>;
+    using Edit = List::Edit;
+    using EditType = List::EditType;
+
+    {
+        List lst{0, 1, 2, 3, 4};
+        lst.MarkErased(++(++lst.begin()));
+        lst.ApplyEdits({
+            Edit{EditType::Erase, 3, 0},
+            Edit{EditType::Insert, 0, 10},
+            Edit{EditType::Insert, 4, 40},
+            Edit{EditType::Insert, 0, 11},
+            Edit{EditType::Erase, 0, 0},
+            Edit{EditType::Insert, 2, 30},
+        });
+        // Исходные позиции относятся к списку {0, 1, 3, 4}
+        assert((lst == List{10, 11, 1, 30, 3, 40}));
+        assert(lst.GetSize() == 6u);
+    }
+
+    // Сравнение с последовательным применением правок к вектору
+    unsigned state = 777;
+    const auto next_random = [&state](unsigned bound) {
+        state = state * 1103515245u + 12345u;
+        return (state >> 16) % bound;
+    };
+    for (int round = 0; round < 50; ++round) {
+        std::vector<int> values;
+        const unsigned size = next_random(20);
+        for (unsigned i = 0; i < size; ++i) {
+            values.push_back(static_cast<int>(i));
+        }
+        List lst;
+        for (auto it = values.rbegin(); it != values.rend(); ++it) {
+            lst.PushFront(*it);
+        }
+
+        std::vector<Edit> edits;
+        std::vector<bool> erased(size, false);
+        for (int i = 0; i < 10; ++i) {
+            const unsigned index = next_random(size + 1);
+            if (index < size && !erased[index] && next_random(2) == 0) {
+                erased[index] = true;
+                edits.push_back(Edit{EditType::Erase, index, 0});
+            } else {
+                edits.push_back(Edit{EditType::Insert, index, 100 + i});
+            }
+        }
+
+        // Ожидаемый результат: вставки перед исходными элементами в порядке пакета
+        std::vector<int> expected;
+        for (unsigned index = 0; index <= size; ++index) {
+            for (const Edit& edit : edits) {
+                if (edit.type == EditType::Insert && edit.index == index) {
+                    expected.push_back(edit.value);
+                }
+            }
+            if (index < size && !erased[index]) {
+                expected.push_back(values[index]);
+            }
+        }
+
+        lst.ApplyEdits(edits);
+        assert(std::vector<int>(lst.begin(), lst.end()) == expected);
+        assert(lst.GetSize() == expected.size());
+    }
+}
+
+// Эта функция проверяет построение и применение сценария правок
+void TestDiff() {
+    {
+        const SingleLinkedList<char> from{'a', 'b', 'c', 'a', 'b', 'b', 'a'};
+        const SingleLinkedList<char> to{'c', 'b', 'a', 'b', 'a', 'c'};
+        const auto script = Diff(from, to);
+        assert(script.size() == 5u);
+        SingleLinkedList<char> patched = from;
+        Patch(patched, script);
+        assert(patched == to);
+        assert(Diff(from, from).empty());
+    }
+
+    // Длина сценария совпадает с n + m - 2·НОП на случайных данных
+    unsigned state = 4242;
+    const auto next_random = [&state](unsigned bound) {
+        state = state * 1103515245u + 12345u;
+        return (state >> 16) % bound;
+    };
+    for (int round = 0; round < 200; ++round) {
+        std::vector<int> from_values(next_random(30));
+        std::vector<int> to_values(next_random(30));
+        for (int& value : from_values) {
+            value = static_cast<int>(next_random(4));
+        }
+        for (int& value : to_values) {
+            value = static_cast<int>(next_random(4));
+        }
+        SingleLinkedList<int> from;
+        SingleLinkedList<int> to;
+        for (auto it = from_values.rbegin(); it != from_values.rend(); ++it) {
+            from.PushFront(*it);
+        }
+        for (auto it = to_values.rbegin(); it != to_values.rend(); ++it) {
+            to.PushFront(*it);
+        }
+
+        std::vector<std::vector<size_t>> lcs(from_values.size() + 1, std::vector<size_t>(to_values.size() + 1, 0));
+        for (size_t i = 1; i <= from_values.size(); ++i) {
+            for (size_t j = 1; j <= to_values.size(); ++j) {
+                lcs[i][j] = from_values[i - 1] == to_values[j - 1] ? lcs[i - 1][j - 1] + 1
+                                                                   : std::max(lcs[i - 1][j], lcs[i][j - 1]);
+            }
+        }
+
+        const auto script = Diff(from, to);
+        assert(script.size() == from_values.size() + to_values.size() - 2 * lcs.back().back());
+        Patch(from, script);
+        assert(from == to);
+    }
+}
+
+// Выполняет function в дочернем процессе и завершает его без деструкторов, как при аварийном завершении
+template <typename Function>
+void RunAndCrash(Function function) {
+    const pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        function();
+        _exit(0);
+    }
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+// Эта функция проверяет журналирование изменений и восстановление списка
+void TestJournal() {
+    char directory[] = "/tmp/single-linked-list-XXXXXX";
+    assert(mkdtemp(directory) != nullptr);
+    const std::string path = std::string(directory) + "/list";
+    ListJournalOptions options;
+    options.group_commit_records = 2;
+
+    // Вставки и удаления повторяются из журнала
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        lst.PushFront("c");
+        lst.PushFront("a");
+        auto b = lst.InsertAfter(lst.begin(), "b");
+        lst.InsertAfter(b, "x");
+        lst.EraseAfter(b);
+        lst.PushFront("z");
+        lst.PopFront();
+        lst.MarkErased(lst.begin());
+        journal.Commit();
+    }
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"b", "c"}));
+
+        // Перестановка записывается снимком
+        lst.InsertAfter(lst.before_begin(), "d");
+        lst.PartialSort(3);
+        journal.Commit();
+        lst.InsertAfter(lst.begin(), "e");
+    }
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"b", "e", "c", "d"}));
+
+        // Фоновое уплотнение не теряет изменений, сделанных во время него
+        journal.StartCompaction();
+        lst.Clear();
+        lst.PushFront("f");
+        journal.WaitForCompaction();
+        lst.PushFront("g");
+    }
+    {
+        // Недописанная запись в конце журнала отбрасывается
+        std::ofstream(path + ".log.2", std::ios::app) << "garbage";
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"g", "f"}));
+        lst.PushFront("h");
+    }
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"h", "g", "f"}));
+
+        // Изменение значений на месте записывается снимком
+        lst.InclusiveScanInPlace(std::plus<std::string>{});
+    }
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"h", "hg", "hgf"}));
+
+        WorkStealingExecutor pool(2);
+        lst.ForEachInPlace([](std::string& value) {
+            value += "!";
+        }, pool);
+    }
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"h!", "hg!", "hgf!"}));
+    }
+
+    // Сбой, когда снимок после перестановки не записан: журнал следующего поколения не должен
+    // ссылаться на номера, которых нет в прежнем снимке
+    const std::string crash_path = std::string(directory) + "/crash";
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(crash_path, lst, options);
+        lst.PushFront("b");
+        lst.PushFront("a");
+        journal.StartCompaction();
+        journal.WaitForCompaction();
+        lst.PushFront("c");
+    }
+    // Дочерний процесс не запускает потоков: после fork многопоточного процесса это небезопасно
+    RunAndCrash([&] {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(crash_path, lst, options);
+
+        // Снимок нельзя переименовать — как при сбое до переименования
+        assert(mkdir((crash_path + ".snap.tmp").c_str(), 0755) == 0);
+        lst.PartialSort(3);
+        try {
+            journal.Commit();
+        } catch (const std::system_error&) {
+        }
+        lst.InsertAfter(lst.begin(), "d");
+        try {
+            journal.Commit();
+        } catch (const std::system_error&) {
+        }
+    });
+    assert(rmdir((crash_path + ".snap.tmp").c_str()) == 0);
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(crash_path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"c", "a", "b"}));
+
+        // Снимок после перестановки записывается до открытия следующего журнала
+        lst.PartialSort(3);
+        lst.InsertAfter(lst.begin(), "d");
+        journal.Commit();
+    }
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(crash_path, lst, options);
+        assert((lst == SingleLinkedList<std::string>{"a", "d", "b", "c"}));
+    }
+
+    // Записи транзакции не попадают на диск до её подтверждения, а отменённые — никогда
+    const std::string transaction_path = std::string(directory) + "/transaction";
+    ListJournalOptions eager_options;
+    eager_options.group_commit_records = 1;
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(transaction_path, lst, eager_options);
+        lst.PushFront("a");
+        lst.BeginTransaction();
+        lst.PushFront("b");
+        lst.CommitTransaction();
+        journal.Commit();
+    }
+    RunAndCrash([&] {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(transaction_path, lst, eager_options);
+        lst.BeginTransaction();
+        lst.PushFront("x");
+        lst.PopFront();
+        lst.Rollback();
+        lst.BeginTransaction();
+        lst.PushFront("y");
+        lst.PushFront("z");
+        journal.Commit();
+    });
+    {
+        SingleLinkedList<std::string> lst;
+        ListJournal<std::string> journal(transaction_path, lst, eager_options);
+        assert((lst == SingleLinkedList<std::string>{"b", "a"}));
+    }
+
+    std::system(("rm -rf " + std::string(directory)).c_str());
+}
+
+// Эта функция проверяет транзакции с откатом изменений
+void TestTransactions() {
+    struct DeletionSpy {
+        ~DeletionSpy() {
+            if (deletion_counter_ptr) {
+                ++(*deletion_counter_ptr);
+            }
+        }
+        int* deletion_counter_ptr = nullptr;
+        int value = 0;
+    };
+
+    // Откат восстанавливает прежнюю цепочку
+    {
+        SingleLinkedList<int> lst{1, 2, 3, 4, 5, 6};
+        const auto first = lst.begin();
+        lst.MarkErased(++lst.begin());
+        auto cursor = lst.MakeCursor(++(++(++lst.begin())));
+
+        lst.BeginTransaction();
+        assert(lst.IsInTransaction());
+        lst.PushFront(0);
+        lst.InsertAfter(lst.begin(), 7);
+        lst.EraseAfter(lst.cbegin());
+        lst.MarkErased(lst.begin());
+        lst.PartialSort(2, std::greater<int>{});
+        lst.ApplyEdits({{SingleLinkedList<int>::EditType::Insert, 0, 9}, {SingleLinkedList<int>::EditType::Erase, 1, 0}});
+        lst.DedupStable();
+        lst.NthElement(1);
+        lst.Clear();
+        lst.PushFront(8);
+        lst.Rollback();
+
+        assert(!lst.IsInTransaction());
+        assert((lst == SingleLinkedList<int>{1, 3, 4, 5, 6}));
+        assert(lst.GetSize() == 5u && lst.GetErasedCount() == 1u);
+        assert(lst.begin() == first);
+        // Clear() в транзакции перевёл курсор в конец, и откат его не возвращает
+        assert(cursor.AtEnd());
+        lst.Compact();
+        assert((lst == SingleLinkedList<int>{1, 3, 4, 5, 6}));
+    }
+
+    // Удалённые в транзакции узлы освобождаются только при подтверждении
+    {
+        int deletion_counter = 0;
+        SingleLinkedList<DeletionSpy> lst{DeletionSpy{}, DeletionSpy{}, DeletionSpy{}};
+        for (auto& spy : lst) {
+            spy.deletion_counter_ptr = &deletion_counter;
+        }
+        lst.BeginTransaction();
+        lst.PopFront();
+        lst.EraseAfter(lst.cbegin());
+        assert(deletion_counter == 0 && lst.GetSize() == 1u);
+        lst.CommitTransaction();
+        assert(deletion_counter == 2 && lst.GetSize() == 1u);
+
+        lst.BeginTransaction();
+        lst.Clear();
+        assert(deletion_counter == 2 && lst.IsEmpty());
+        lst.Rollback();
+        assert(deletion_counter == 2 && lst.GetSize() == 1u);
+    }
+
+    // Курсор на вставленном в транзакции элементе переходит на следующий сохраняемый
+    {
+        SingleLinkedList<int> lst{1, 2};
+        lst.BeginTransaction();
+        auto inserted = lst.InsertAfter(lst.begin(), 10);
+        lst.InsertAfter(inserted, 11);
+        auto cursor = lst.MakeCursor(inserted);
+        lst.Rollback();
+        assert(*cursor == 2);
+    }
+
+    // Удаления в цикле и Compact() в транзакции пишут в журнал, зарезервированный заранее, и откатываются
+    static_assert(noexcept(std::declval<SingleLinkedList<int>&>().PopFront()));
+    static_assert(noexcept(std::declval<SingleLinkedList<int>&>().Compact()));
+    {
+        SingleLinkedList<int> lst{1, 2, 3, 4, 5, 6, 7, 8};
+        lst.BeginTransaction();
+        for (auto it = lst.begin(); it != lst.end(); ++it) {
+            if (*it % 2 == 0) {
+                lst.MarkErased(it);
+            }
+        }
+        assert(lst.Compact() == 4u);
+        while (!lst.IsEmpty()) {
+            lst.PopFront();
+        }
+        lst.Rollback();
+        assert((lst == SingleLinkedList<int>{1, 2, 3, 4, 5, 6, 7, 8}));
+        assert(lst.GetErasedCount() == 0u);
+    }
+}
+
+// Эта функция проверяет преобразование списка в неизменяемое представление и обратно
+void TestFreeze() {
+    SingleLinkedList<std::string> lst{"a", "b", "c", "d"};
+    lst.MarkErased(++lst.begin());
+    const FrozenList<std::string> frozen = lst.Freeze();
+    assert(lst.IsEmpty() && lst.GetErasedCount() == 0u);
+    assert(frozen.GetSize() == 3u);
+    assert(frozen[0] == "a" && frozen[1] == "c" && frozen[2] == "d");
+    assert(frozen.end() - frozen.begin() == 3 && frozen.data() == &frozen[0]);
+    assert((std::vector<std::string>(frozen.begin(), frozen.end()) == std::vector<std::string>{"a", "c", "d"}));
+
+    SingleLinkedList<std::string> thawed = frozen.Thaw();
+    assert((thawed == SingleLinkedList<std::string>{"a", "c", "d"}));
+    thawed.PushFront("z");
+
+    FrozenList<std::string> moved_from = thawed.Freeze();
+    SingleLinkedList<std::string> moved = std::move(moved_from).Thaw();
+    assert(moved_from.IsEmpty());
+    assert((moved == SingleLinkedList<std::string>{"z", "a", "c", "d"}));
+
+    SingleLinkedList<std::string> target;
+    target = std::move(moved);
+    assert(moved.IsEmpty() && target.GetSize() == 4u);
+}
+
+// Эта функция проверяет чередующийся поиск в нескольких списках
+void TestFindInterleaved() {
+    std::vector<SingleLinkedList<int>> lists(40);
+    std::vector<const SingleLinkedList<int>*> probed_lists;
+    std::vector<int> keys;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        for (int value = static_cast<int>(i % 7); value >= 0; --value) {
+            lists[i].PushFront(value);
+        }
+        if (i % 5 == 0) {
+            lists[i].MarkErased(lists[i].begin());
+        }
+        // Каждый список проверяется дважды с разными ключами
+        probed_lists.push_back(&lists[i]);
+        keys.push_back(static_cast<int>(i % 4));
+        probed_lists.push_back(&lists[i]);
+        keys.push_back(100);
+    }
+
+    std::vector<SingleLinkedList<int>::ConstIterator> found;
+    for (size_t group_size : {1u, 3u, 16u, 100u}) {
+        SingleLinkedList<int>::FindInterleaved(probed_lists, keys, found, std::equal_to<int>{}, group_size);
+        assert(found.size() == keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const auto& lst = *probed_lists[i];
+            const auto expected = std::find(lst.begin(), lst.end(), keys[i]);
+            assert(found[i] == expected);
+        }
+    }
+}
+
+// Эта функция проверяет запись цепочки буферов без копирования
+void TestWriteBuffers() {
+    // Формирование iovec и сдвиг курсора после частичной записи
+    {
+        SingleLinkedList<std::string> buffers{"abc", "", "de", "fghij"};
+        auto cursor = MakeGatherCursor(buffers);
+        iovec batch[8];
+        assert(ToIovec(cursor, batch, 8) == 3u);
+        assert(batch[0].iov_base == buffers.begin()->data() && batch[0].iov_len == 3u);
+
+        AdvanceGatherCursor(cursor, 4);
+        assert(ToIovec(cursor, batch, 1) == 1u);
+        assert(std::string(static_cast<const char*>(batch[0].iov_base), batch[0].iov_len) == "e");
+        AdvanceGatherCursor(cursor, 6);
+        assert(cursor.IsDone() && ToIovec(cursor, batch, 8) == 0u);
+    }
+
+    // Возобновление записи в неблокирующий канал
+    {
+        SingleLinkedList<std::string> buffers;
+        std::string expected;
+        for (int i = 0; i < 300; ++i) {
+            buffers.PushFront(std::string(1000 + i, static_cast<char>('a' + i % 26)));
+        }
+        for (const auto& buffer : buffers) {
+            expected += buffer;
+        }
+
+        int pipe_fds[2];
+        assert(pipe(pipe_fds) == 0);
+        fcntl(pipe_fds[1], F_SETFL, O_NONBLOCK);
+        fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+
+        std::string received;
+        auto cursor = MakeGatherCursor(buffers);
+        char chunk[4096];
+        while (!cursor.IsDone()) {
+            WriteSome(pipe_fds[1], cursor);
+            for (ssize_t count; (count = read(pipe_fds[0], chunk, sizeof(chunk))) > 0; ) {
+                received.append(chunk, static_cast<size_t>(count));
+            }
+        }
+        close(pipe_fds[1]);
+        for (ssize_t count; (count = read(pipe_fds[0], chunk, sizeof(chunk))) > 0; ) {
+            received.append(chunk, static_cast<size_t>(count));
+        }
+        close(pipe_fds[0]);
+        assert(received == expected);
+    }
+}
+
+// Эта функция проверяет загрузку строк файла через отображение в память
+void TestMappedLines() {
+    char directory[] = "/tmp/single-linked-list-XXXXXX";
+    assert(mkdtemp(directory) != nullptr);
+    const std::string path = std::string(directory) + "/lines.txt";
+
+    {
+        std::ofstream(path) << "first\n\nthird\nlast";
+        MappedLineList mapped = LoadMappedLines(path);
+        assert((mapped.GetLines() == SingleLinkedList<std::string_view>{"first", "", "third", "last"}));
+
+        // Строки указывают в отображение файла, а не в копии
+        const char* begin = mapped.GetFile().data();
+        for (std::string_view line : mapped.GetLines()) {
+            assert(line.data() >= begin && line.data() + line.size() <= begin + mapped.GetFile().size());
+        }
+
+        // Перемещение не делает строки недействительными
+        MappedLineList moved = std::move(mapped);
+        assert(moved.GetLines().GetSize() == 4u && *moved.GetLines().begin() == "first");
+    }
+
+    {
+        std::ofstream(path) << "a\nb\n";
+        assert((LoadMappedLines(path).GetLines() == SingleLinkedList<std::string_view>{"a", "b"}));
+
+        std::ofstream(path, std::ios::trunc).flush();
+        assert(LoadMappedLines(path).GetLines().IsEmpty());
+    }
+
+    bool thrown = false;
+    try {
+        LoadMappedLines(std::string(directory) + "/missing");
+    } catch (const std::system_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::system(("rm -rf " + std::string(directory)).c_str());
+}
+
+// Эта функция проверяет перенос цепочек и конвейерную загрузку списка
+void TestListStream() {
+    // Перенос цепочки вместе с курсорами и откат переноса
+    {
+        SingleLinkedList<int> lst{1, 5};
+        SingleLinkedList<int> other{2, 3, 4};
+        auto other_last = std::next(other.cbegin(), 2);
+        auto cursor = other.MakeCursor(std::next(other.cbegin()));
+
+        lst.BeginTransaction();
+        auto last = lst.SpliceAfter(lst.cbegin(), std::move(other), other_last);
+        assert(*last == 4 && other.IsEmpty());
+        assert((lst == SingleLinkedList<int>{1, 2, 3, 4, 5}) && lst.GetSize() == 5u);
+        lst.EraseAfter(lst.cbegin());
+        assert(*cursor == 3);
+
+        lst.Rollback();
+        assert((lst == SingleLinkedList<int>{1, 5}) && lst.GetSize() == 2u);
+        assert(*cursor == 5);
+    }
+
+    char directory[] = "/tmp/single-linked-list-XXXXXX";
+    assert(mkdtemp(directory) != nullptr);
+    const std::string path = std::string(directory) + "/stream";
+    ListStreamOptions options;
+    options.chunk_elements = 7;
+    options.max_chunks_in_flight = 3;
+
+    {
+        SingleLinkedList<std::string> lst;
+        auto last = lst.before_begin();
+        for (int i = 0; i < 1000; ++i) {
+            last = lst.InsertAfter(last, std::to_string(i));
+        }
+
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        SaveListStream(fd, lst, options);
+        close(fd);
+
+        const int read_fd = open(path.c_str(), O_RDONLY);
+        SingleLinkedList<std::string> loaded = LoadListStream<std::string>(read_fd, options);
+        close(read_fd);
+        assert(loaded == lst && loaded.GetSize() == 1000u);
+    }
+
+    {
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        SaveListStream(fd, SingleLinkedList<int>{}, options);
+        close(fd);
+
+        const int read_fd = open(path.c_str(), O_RDONLY);
+        assert(LoadListStream<int>(read_fd).IsEmpty());
+        close(read_fd);
+    }
+
+    // Обрезанный файл не загружается
+    {
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        SaveListStream(fd, SingleLinkedList<int>{1, 2, 3}, options);
+        close(fd);
+        assert(truncate(path.c_str(), 20) == 0);
+
+        const int read_fd = open(path.c_str(), O_RDONLY);
+        bool thrown = false;
+        try {
+            LoadListStream<int>(read_fd);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        close(read_fd);
+        assert(thrown);
+    }
+
+    // Размер блока больше остатка файла отвергается до выделения памяти под него
+    {
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        SaveListStream(fd, SingleLinkedList<int>{1, 2, 3}, options);
+        close(fd);
+
+        const int patch_fd = open(path.c_str(), O_WRONLY);
+        const std::uint64_t huge_size = std::uint64_t{1} << 62;
+        assert(pwrite(patch_fd, &huge_size, sizeof(huge_size), 8 + sizeof(std::uint64_t)) == sizeof(huge_size));
+        close(patch_fd);
+
+        const int read_fd = open(path.c_str(), O_RDONLY);
+        bool thrown = false;
+        try {
+            LoadListStream<int>(read_fd);
+        } catch (const std::runtime_error& error) {
+            thrown = std::string(error.what()) == "corrupted list stream";
+        }
+        close(read_fd);
+        assert(thrown);
+
+        WorkStealingExecutor single_worker(1);
+        assert(!single_worker.IsWorkerThread());
+        assert(Submit(single_worker, [&single_worker]() {
+            return single_worker.IsWorkerThread();
+        }).get());
+    }
+
+    std::system(("rm -rf " + std::string(directory)).c_str());
+}
+
+// Эта функция проверяет асинхронное сохранение и загрузку списка
+void TestAsyncIo() {
+    char directory[] = "/tmp/single-linked-list-XXXXXX";
+    assert(mkdtemp(directory) != nullptr);
+    const std::string path = std::string(directory) + "/async";
+
+    SingleLinkedList<std::string> lst;
+    auto last = lst.before_begin();
+    for (int i = 0; i < 2000; ++i) {
+        last = lst.InsertAfter(last, std::string(i % 50, 'x') + std::to_string(i));
+    }
+    const SingleLinkedList<std::string> expected = lst;
+
+    // Через io_uring и через pread/pwrite
+    for (bool use_io_uring : {true, false}) {
+        AsyncListIoOptions options;
+        options.chunk_elements = 64;
+        options.read_block_size = 4096;
+        options.queue_depth = 4;
+        options.use_io_uring = use_io_uring;
+
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        auto saved = SaveListAsync(fd, lst, options);
+        // Список можно изменять, пока снимок записывается
+        lst.PushFront("changed");
+        lst.PopFront();
+        saved.get();
+
+        SingleLinkedList<std::string> loaded = LoadListAsync<std::string>(fd, options).get();
+        assert(loaded == expected && loaded.GetSize() == 2000u);
+        close(fd);
+
+        // Формат совпадает с потоковым
+        const int read_fd = open(path.c_str(), O_RDONLY);
+        assert(LoadListStream<std::string>(read_fd) == expected);
+        close(read_fd);
+    }
+
+    // Ошибка ввода-вывода передаётся через future
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        bool thrown = false;
+        try {
+            SaveListAsync(fd, lst).get();
+        } catch (const std::system_error&) {
+            thrown = true;
+        }
+        close(fd);
+        assert(thrown);
+    }
+
+    std::system(("rm -rf " + std::string(directory)).c_str());
+}
+
+// Эта функция проверяет ленивое вычисление и запоминание элементов
+void TestLazyList() {
+    // Бесконечная последовательность вычисляется только до используемого места
+    {
+        int calls = 0;
+        long long current = 0;
+        long long next = 1;
+        LazyList<long long> fibonacci([&]() -> std::optional<long long> {
+            ++calls;
+            long long value = current;
+            current = std::exchange(next, current + next);
+            return value;
+        });
+        assert(calls == 0);
+
+        auto it = std::find_if(fibonacci.begin(), fibonacci.end(), [](long long value) {
+            return value > 50;
+        });
+        assert(*it == 55 && calls == 11);
+
+        // Повторный обход использует запомненные узлы; переход к следующему элементу вычисляет его
+        assert(std::accumulate(fibonacci.begin(), it, 0LL) == 88);
+        assert(calls == 11 && fibonacci.GetForced().GetSize() == 11u);
+        assert(*std::next(it) == 89 && calls == 12);
+
+        assert(fibonacci.Force(3) == 3u && !fibonacci.IsExhausted());
+        SingleLinkedList<long long> forced = std::move(fibonacci).ReleaseForced();
+        assert(forced.GetSize() == 15u && *std::next(forced.begin(), 14) == 377);
+    }
+
+    // Конечная последовательность с вычисленным началом
+    {
+        int remaining = 3;
+        LazyList<int> lst(SingleLinkedList<int>{1, 2}, [&]() -> std::optional<int> {
+            if (remaining == 0) {
+                return std::nullopt;
+            }
+            return 10 * remaining--;
+        });
+        assert(std::distance(lst.begin(), lst.end()) == 5);
+        assert(lst.IsExhausted());
+        assert((lst.GetForced() == SingleLinkedList<int>{1, 2, 30, 20, 10}));
+        lst.ForceAll();
+        assert(lst.GetForced().GetSize() == 5u);
+    }
+
+    {
+        LazyList<int> empty([]() -> std::optional<int> {
+            return std::nullopt;
+        });
+        assert(empty.begin() == empty.end() && empty.IsExhausted());
+    }
+}
+
+// Эта функция проверяет параллельные префиксные суммы
+void TestScan() {
+    std::vector<int64_t> values;
+    SingleLinkedList<int64_t> lst;
+    auto last = lst.before_begin();
+    for (int64_t i = 0; i < 10007; ++i) {
+        values.push_back(i % 13 - 6);
+        last = lst.InsertAfter(last, values.back());
+    }
+
+    WorkStealingExecutor pool(3);
+    for (ListExecutor* executor : {static_cast<ListExecutor*>(&InlineExecutor::Instance()), static_cast<ListExecutor*>(&pool)}) {
+        SingleLinkedList<int64_t> inclusive = lst;
+        inclusive.InclusiveScanInPlace(std::plus<int64_t>{}, *executor);
+        std::vector<int64_t> expected(values.size());
+        std::partial_sum(values.begin(), values.end(), expected.begin());
+        assert(std::equal(inclusive.begin(), inclusive.end(), expected.begin(), expected.end()));
+
+        SingleLinkedList<int64_t> exclusive = lst;
+        exclusive.ExclusiveScanInPlace(100, std::plus<int64_t>{}, *executor);
+        assert(*exclusive.begin() == 100);
+        assert(*std::next(exclusive.begin(), 5000) == 100 + expected[4999]);
+    }
+
+    // Логически удалённые элементы не участвуют, некоммутативная операция
+    {
+        SingleLinkedList<std::string> words;
+        auto word = words.before_begin();
+        for (int i = 0; i < 3000; ++i) {
+            word = words.InsertAfter(word, std::string(1, static_cast<char>('a' + i % 3)));
+        }
+        words.MarkErased(words.begin());
+
+        words.InclusiveScanInPlace(std::plus<std::string>{}, pool);
+        assert(words.begin()->size() == 1u && *words.begin() == "b");
+        auto it = std::next(words.begin(), 2998);
+        assert(it->size() == 2999u && it->substr(0, 4) == "bcab");
+    }
+
+    SingleLinkedList<int64_t> empty;
+    empty.InclusiveScanInPlace();
+    assert(empty.IsEmpty());
+}
+
+// Эта функция проверяет исполнители и параллельные операции над списком
+void TestExecutor() {
+    WorkStealingExecutor pool(4);
+
+    // Вложенные параллельные циклы в потоках пула не блокируют его
+    {
+        std::atomic<int> sum{0};
+        ParallelFor(pool, 8, [&](size_t i) {
+            ParallelFor(pool, 100, [&](size_t j) {
+                sum += static_cast<int>(i * j);
+            });
+        });
+        assert(sum == 28 * 4950);
+    }
+
+    // Исключение передаётся вызывающему
+    {
+        bool thrown = false;
+        try {
+            ParallelFor(pool, 50, [](size_t i) {
+                if (i == 17) {
+                    throw std::runtime_error("failed");
+                }
+            });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(Submit(pool, [] { return 42; }).get() == 42);
+    }
+
+    SingleLinkedList<int64_t> lst;
+    auto last = lst.before_begin();
+    for (int64_t i = 1; i <= 5000; ++i) {
+        last = lst.InsertAfter(last, i);
+    }
+    lst.MarkErased(lst.begin());
+
+    // Пул приложения через переходник
+    UserPoolExecutor user_pool([&pool](std::function<void()> task) {
+        pool.Execute(std::move(task));
+    }, 2);
+
+    for (ListExecutor* executor : {static_cast<ListExecutor*>(&pool), static_cast<ListExecutor*>(&user_pool),
+                                   static_cast<ListExecutor*>(&InlineExecutor::Instance())}) {
+        assert(lst.Reduce(0, std::plus<int64_t>{}, *executor) == 5000 * 5001 / 2 - 1);
+
+        std::atomic<int64_t> count{0};
+        std::atomic<int64_t> sum{0};
+        std::as_const(lst).ForEach([&sum](const int64_t& value) {
+            sum += value;
+        }, *executor);
+        assert(sum == 5000 * 5001 / 2 - 1);
+        lst.ForEachInPlace([&count](int64_t& value) {
+            value *= 2;
+            ++count;
+        }, *executor);
+        assert(count == 4999);
+        for (int64_t& value : lst) {
+            value /= 2;
+        }
+    }
+
+    // Некоммутативная свёртка сохраняет порядок
+    SingleLinkedList<std::string> words;
+    auto word = words.before_begin();
+    for (int i = 0; i < 4000; ++i) {
+        word = words.InsertAfter(word, std::to_string(i % 10));
+    }
+    const std::string joined = words.Reduce(std::string(">"), std::plus<std::string>{}, pool);
+    assert(joined.size() == 4001u && joined.substr(0, 12) == ">01234567890");
+}
+
+// Эта функция проверяет выделение узлов из блоков точного размера
+void TestNodeArena() {
+    using Arena = SingleLinkedList<char>::Arena;
+    const auto before = Arena::Instance().GetStats();
+
+    {
+        SingleLinkedList<char> lst;
+        for (int i = 0; i < 10000; ++i) {
+            lst.PushFront(static_cast<char>(i));
+        }
+        const auto filled = Arena::Instance().GetStats();
+        assert(filled.live_count == before.live_count + 10000);
+        // Узел с однобайтовым значением занимает 16 байт, а не 32, как блок malloc
+        assert(filled.reserved_bytes - before.reserved_bytes <= 10000 * 16 + 2 * Arena::kSlabSize);
+
+        // Освобождённые места используются повторно
+        lst.PopFront();
+        lst.PopFront();
+        lst.PushFront('x');
+        assert(Arena::Instance().GetStats().slab_count == filled.slab_count);
+    }
+    assert(Arena::Instance().GetStats().live_count == before.live_count);
+
+    // Узлы, освобождённые в другом потоке, проходят через его кеш и возвращаются в блоки при его завершении
+    {
+        SingleLinkedList<char> lst;
+        for (int i = 0; i < 1000; ++i) {
+            lst.PushFront('a');
+        }
+        std::vector<std::thread> threads;
+        threads.emplace_back([moved = std::move(lst)]() mutable {
+            moved.Clear();
+        });
+        threads.emplace_back([] {
+            SingleLinkedList<char> local;
+            for (int i = 0; i < 1000; ++i) {
+                local.PushFront('b');
+                if (i % 3 == 0) {
+                    local.PopFront();
+                }
+            }
+        });
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    assert(Arena::Instance().GetStats().live_count == before.live_count);
+
+    // Кеш другого потока сбрасывается по запросу при следующем обращении этого потока к распределителю
+    {
+        std::atomic<int> stage{0};
+        std::thread thread([&stage] {
+            SingleLinkedList<char> local;
+            for (int i = 0; i < 6; ++i) {
+                local.PushFront('c');
+            }
+            for (int i = 0; i < 5; ++i) {
+                local.PopFront();
+            }
+            stage = 1;
+            while (stage != 2) {
+                std::this_thread::yield();
+            }
+            local.PopFront();
+            stage = 3;
+            while (stage != 4) {
+                std::this_thread::yield();
+            }
+        });
+        while (stage != 1) {
+            std::this_thread::yield();
+        }
+        Arena::Instance().FlushThreadCaches();
+        assert(Arena::Instance().GetStats().cached_count >= 5);
+        stage = 2;
+        while (stage != 3) {
+            std::this_thread::yield();
+        }
+        assert(Arena::Instance().GetStats().cached_count == 1);
+        stage = 4;
+        thread.join();
+    }
+    assert(Arena::Instance().GetStats().cached_count == 0);
+
+    // Признак удалённого узла хранится в указателе и не увеличивает узел {значение, указатель}
+    static_assert(std::is_same_v<SingleLinkedList<std::int64_t>::Arena, NodeArena<16, 8>>);
+
+    // Значения с выравниванием строже указателя
+    struct alignas(64) Wide {
+        char data[40];
+    };
+    SingleLinkedList<Wide> wide;
+    for (int i = 0; i < 100; ++i) {
+        wide.PushFront(Wide{});
+        assert(reinterpret_cast<std::uintptr_t>(&*wide.begin()) % 64 == 0);
+    }
+}
+
+// Эта функция проверяет возврат системе памяти пустых блоков распределителя узлов
+void TestNodeMemoryRelease() {
+    struct Payload {
+        char data[200];
+    };
+    using Arena = SingleLinkedList<Payload>::Arena;
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    // Правила общие для процесса и восстанавливаются при выходе из блока
+    struct PolicyGuard {
+        ~PolicyGuard() {
+            SetNodeMemoryPolicy(old_policy);
+        }
+        NodeMemoryPolicy old_policy = GetNodeMemoryPolicy();
+    };
+    // Давление не проверяется, чтобы распределитель не возвращал блоки сам
+    PolicyGuard quiet_guard;
+    NodeMemoryPolicy quiet_policy;
+    quiet_policy.psi_some_avg10_limit = 0;
+    SetNodeMemoryPolicy(quiet_policy);
+
+    SingleLinkedList<Payload> lst;
+    for (int i = 0; i < 2000; ++i) {
+        lst.PushFront(Payload{});
+    }
+    void* slab = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(&*lst.begin()) & ~(Arena::kSlabSize - 1));
+    const auto filled = Arena::Instance().GetStats();
+    assert(filled.empty_slab_count == 0);
+
+    lst.Clear();
+    // Места в кеше потока живыми не считаются, а GetStats() кеш не сбрасывает
+    const auto cleared = Arena::Instance().GetStats();
+    assert(cleared.live_count == 0 && cleared.cached_count != 0);
+    assert(Arena::Instance().GetStats().cached_count == cleared.cached_count);
+    Arena::Instance().FlushThreadCaches();
+    const auto flushed = Arena::Instance().GetStats();
+    assert(flushed.live_count == 0 && flushed.cached_count == 0);
+    // Без давления на память пустые блоки остаются в распределителе
+    assert(flushed.empty_slab_count == filled.slab_count && flushed.released_slab_count == 0);
+
+    ReleaseNodeMemory();
+    const auto released = Arena::Instance().GetStats();
+    assert(released.empty_slab_count == 0);
+    assert(released.released_slab_count == filled.slab_count);
+    assert(released.slab_count == filled.slab_count);
+
+    // Страницы блока, кроме страницы с заголовком, больше не занимают память
+    std::vector<unsigned char> resident(Arena::kSlabSize / page_size);
+    assert(mincore(slab, Arena::kSlabSize, resident.data()) == 0);
+    assert(resident[0] & 1);
+    for (size_t i = 1; i < resident.size(); ++i) {
+        assert(!(resident[i] & 1));
+    }
+
+    // Возвращённые блоки используются повторно без новых отображений
+    for (int i = 0; i < 2000; ++i) {
+        Payload payload{};
+        payload.data[0] = static_cast<char>(i);
+        lst.PushFront(payload);
+    }
+    assert(Arena::Instance().GetStats().slab_count == filled.slab_count);
+    assert(Arena::Instance().GetStats().released_slab_count == 0);
+    int expected = 1999;
+    for (const Payload& payload : lst) {
+        assert(payload.data[0] == static_cast<char>(expected--));
+    }
+
+    // Возврат при превышении порога RSS
+    {
+        PolicyGuard guard;
+        NodeMemoryPolicy policy;
+        policy.psi_some_avg10_limit = 0;
+        policy.rss_limit_bytes = 1;
+        policy.check_interval = std::chrono::milliseconds{0};
+        SetNodeMemoryPolicy(policy);
+
+        // Освобождение узлов само проверяет давление и возвращает пустые блоки. Пустым может остаться
+        // только блок, места которого освобождены в кеш потока уже после последней проверки
+        lst.Clear();
+        assert(Arena::Instance().GetStats().released_slab_count + 1 >= filled.slab_count);
+
+        // Как и освобождение узлов по одному
+        for (int i = 0; i < 2000; ++i) {
+            lst.PushFront(Payload{});
+        }
+        while (!lst.IsEmpty()) {
+            lst.PopFront();
+        }
+        assert(Arena::Instance().GetStats().released_slab_count + 1 >= filled.slab_count);
+
+        // Явная проверка возвращает остальное
+        ReleaseNodeMemoryIfUnderPressure();
+        assert(Arena::Instance().GetStats().empty_slab_count == 0);
+        assert(Arena::Instance().GetStats().released_slab_count == filled.slab_count);
+    }
+    assert(GetNodeMemoryPolicy().rss_limit_bytes == 0);
+}
+
+// Эта функция проверяет очередь одного производителя и одного потребителя
+void TestSpscQueue() {
+    {
+        SpscQueue<std::string> queue;
+        assert(queue.IsEmpty());
+        assert(!queue.TryPop());
+
+        queue.Push(std::string("a"));
+        queue.Push(std::string("b"));
+        assert(!queue.IsEmpty());
+        assert(*queue.TryPop() == std::string("a"));
+        queue.Push(std::string("c"));
+        assert(*queue.TryPop() == std::string("b"));
+        assert(*queue.TryPop() == std::string("c"));
+        assert(!queue.TryPop());
+
+        // Элементы, оставшиеся в очереди, освобождаются вместе с ней
+        queue.Push(std::string(100, 'x'));
+    }
+
+    // Освобождённые потребителем узлы используются производителем повторно
+    {
+        using Arena = SingleLinkedList<std::int64_t>::Arena;
+        SpscQueue<std::int64_t> queue;
+        queue.Push(0);
+        queue.Push(1);
+        const size_t live_count = Arena::Instance().GetStats().live_count;
+        for (std::int64_t i = 2; i < 10000; ++i) {
+            assert(*queue.TryPop() == i - 2);
+            queue.Push(i);
+        }
+        assert(Arena::Instance().GetStats().live_count == live_count);
+    }
+
+    // Передача между потоками сохраняет порядок элементов
+    {
+        constexpr int kCount = 200000;
+        SpscQueue<std::string> queue;
+        std::thread producer([&queue]() {
+            for (int i = 0; i < kCount; ++i) {
+                queue.Push(std::to_string(i));
+            }
+        });
+        for (int i = 0; i < kCount;) {
+            if (auto value = queue.TryPop()) {
+                assert(*value == std::to_string(i));
+                ++i;
+            }
+        }
+        producer.join();
+        assert(queue.IsEmpty());
+    }
+}
+
+// Эта функция проверяет хеш-таблицу без блокировок на упорядоченном по разделению списке
+void TestSplitOrderedMap() {
+    {
+        SplitOrderedMap<int, std::string> map;
+        assert(map.Insert(1, "one"));
+        assert(map.Insert(2, "two"));
+        assert(!map.Insert(1, "uno"));
+        assert(map.GetSize() == 2);
+        assert(*map.Find(1) == "one");
+        assert(!map.Find(3));
+        assert(map.Erase(1));
+        assert(!map.Erase(1));
+        assert(!map.Contains(1));
+        assert(map.Contains(2));
+    }
+
+    // Таблица растёт, не теряя элементов, в том числе с одинаковыми хешами
+    {
+        struct CollidingHash {
+            size_t operator()(int key) const {
+                return static_cast<size_t>(key / 4);
+            }
+        };
+        SplitOrderedMap<int, int, CollidingHash> map;
+        constexpr int kCount = 100000;
+        for (int i = 0; i < kCount; ++i) {
+            assert(map.Insert(i, -i));
+        }
+        assert(map.GetSize() == kCount);
+        assert(map.GetBucketCount() >= kCount / 8);
+        for (int i = 0; i < kCount; i += 2) {
+            assert(map.Erase(i));
+        }
+        for (int i = 0; i < kCount; ++i) {
+            assert(map.Find(i) == (i % 2 == 0 ? std::nullopt : std::optional<int>(-i)));
+        }
+    }
+
+    // Удалённые значения освобождаются, когда их больше не могут видеть другие потоки
+    {
+        static int live_count = 0;
+        struct Counted {
+            Counted() {
+                ++live_count;
+            }
+            Counted(const Counted&) {
+                ++live_count;
+            }
+            ~Counted() {
+                --live_count;
+            }
+        };
+        SplitOrderedMap<int, Counted> map;
+        for (int i = 0; i < 1000; ++i) {
+            map.Insert(i, Counted());
+        }
+        for (int i = 0; i < 1000; ++i) {
+            map.Erase(i);
+        }
+        for (int i = 0; i < 3; ++i) {
+            EpochReclamation::Instance().Collect();
+        }
+        assert(live_count == 0);
+    }
+
+    // Одновременные вставки, удаления и поиск из нескольких потоков
+    {
+        constexpr int kThreadCount = 4;
+        constexpr int kPerThread = 20000;
+        SplitOrderedMap<int, int> map;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreadCount; ++t) {
+            threads.emplace_back([&map, t]() {
+                for (int i = t * kPerThread; i < (t + 1) * kPerThread; ++i) {
+                    assert(map.Insert(i, i));
+                    assert(map.Find(i) == i);
+                    if (i % 3 == 0) {
+                        assert(map.Erase(i));
+                    }
+                    // Ключи соседнего потока только читаются
+                    const int other = (i + kPerThread) % (kThreadCount * kPerThread);
+                    const std::optional<int> value = map.Find(other);
+                    assert(!value || *value == other);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        assert(map.GetSize() == static_cast<size_t>(kThreadCount * kPerThread - (kThreadCount * kPerThread + 2) / 3));
+        for (int i = 0; i < kThreadCount * kPerThread; ++i) {
+            assert(map.Contains(i) == (i % 3 != 0));
+        }
+    }
+}
+
+// Эта функция проверяет упорядоченный словарь без блокировок на списке с пропусками
+void TestSkipListMap() {
+    {
+        SkipListMap<int, std::string> map;
+        assert(map.Insert(3, "three"));
+        assert(map.Insert(1, "one"));
+        assert(map.Insert(2, "two"));
+        assert(!map.Insert(2, "deux"));
+        assert(map.GetSize() == 3);
+        assert(*map.Find(2) == "two");
+        assert(!map.Find(4));
+        assert(map.Erase(1));
+        assert(!map.Erase(1));
+        assert(!map.Contains(1));
+
+        EpochReclamation::Guard guard;
+        std::vector<int> keys;
+        for (const auto& [key, value] : map) {
+            keys.push_back(key);
+        }
+        assert((keys == std::vector<int>{2, 3}));
+        assert(map.LowerBound(0)->first == 2);
+        assert(map.LowerBound(3)->second == "three");
+        assert(map.LowerBound(4) == map.end());
+    }
+
+    // Порядок обхода и обход диапазона на большом словаре
+    {
+        SkipListMap<int, int> map;
+        constexpr int kCount = 50000;
+        std::vector<int> keys(kCount);
+        std::iota(keys.begin(), keys.end(), 0);
+        std::mt19937 random(7);
+        std::shuffle(keys.begin(), keys.end(), random);
+        for (int key : keys) {
+            assert(map.Insert(key, key * 2));
+        }
+        for (int key = 0; key < kCount; key += 2) {
+            assert(map.Erase(key));
+        }
+        int expected = 1;
+        map.ForEach([&expected](const std::pair<const int, int>& entry) {
+            assert(entry.first == expected && entry.second == expected * 2);
+            expected += 2;
+        });
+        assert(expected == kCount + 1);
+
+        std::vector<int> range;
+        map.ForEachInRange(100, 110, [&range](const std::pair<const int, int>& entry) {
+            range.push_back(entry.first);
+        });
+        assert((range == std::vector<int>{101, 103, 105, 107, 109}));
+    }
+
+    // Удалённые значения освобождаются, когда их больше не могут видеть другие потоки
+    {
+        static int live_count = 0;
+        struct Counted {
+            Counted() {
+                ++live_count;
+            }
+            Counted(const Counted&) {
+                ++live_count;
+            }
+            ~Counted() {
+                --live_count;
+            }
+        };
+        {
+            SkipListMap<int, Counted> map;
+            for (int i = 0; i < 1000; ++i) {
+                map.Insert(i, Counted());
+            }
+            for (int i = 0; i < 500; ++i) {
+                map.Erase(i);
+            }
+            for (int i = 0; i < 3; ++i) {
+                EpochReclamation::Instance().Collect();
+            }
+            assert(live_count == 500);
+        }
+        assert(live_count == 0);
+    }
+
+    // Одновременные вставки и удаления с обходом по порядку из другого потока
+    {
+        constexpr int kThreadCount = 4;
+        constexpr int kPerThread = 20000;
+        SkipListMap<int, int> map;
+        std::atomic<bool> stop{false};
+        std::thread scanner([&map, &stop]() {
+            while (!stop) {
+                EpochReclamation::Guard guard;
+                int previous = -1;
+                for (const auto& entry : map) {
+                    assert(entry.first > previous && entry.second == entry.first);
+                    previous = entry.first;
+                }
+            }
+        });
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreadCount; ++t) {
+            threads.emplace_back([&map, t]() {
+                // Потоки вставляют чередующиеся ключи, чтобы соседние узлы менялись одновременно
+                for (int i = t; i < kThreadCount * kPerThread; i += kThreadCount) {
+                    assert(map.Insert(i, i));
+                    assert(map.Find(i) == i);
+                    if (i % 3 == 0) {
+                        assert(map.Erase(i));
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        stop = true;
+        scanner.join();
+        assert(map.GetSize() == static_cast<size_t>(kThreadCount * kPerThread - (kThreadCount * kPerThread + 2) / 3));
+        for (int i = 0; i < kThreadCount * kPerThread; ++i) {
+            assert(map.Contains(i) == (i % 3 != 0));
+        }
+    }
+}
+
 int main() {
     Test();
+    TestSelection();
+    TestRing();
+    TestTombstones();
+    TestCursors();
+    TestFindAll();
+    TestDedupStable();
+    TestApplyEdits();
+    TestDiff();
+    TestJournal();
+    TestTransactions();
+    TestFreeze();
+    TestFindInterleaved();
+    TestWriteBuffers();
+    TestMappedLines();
+    TestListStream();
+    TestAsyncIo();
+    TestLazyList();
+    TestScan();
+    TestExecutor();
+    TestNodeArena();
+    TestNodeMemoryRelease();
+    TestSpscQueue();
+    TestSplitOrderedMap();
+    TestSkipListMap();
 }
@@ -0,0 +1,807 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#include <sanitizer/asan_interface.h>
+#define NODE_ARENA_POISON(address, size) ASAN_POISON_MEMORY_REGION(address, size)
+#define NODE_ARENA_UNPOISON(address, size) ASAN_UNPOISON_MEMORY_REGION(address, size)
+#else
+#define NODE_ARENA_POISON(address, size) ((void)(address), (void)(size))
+#define NODE_ARENA_UNPOISON(address, size) ((void)(address), (void)(size))
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/*
+ * Правила возврата системе памяти пустых блоков распределителей узлов
+ * Пустые блоки возвращаются по запросу — ReleaseNodeMemory() — и автоматически, если давление на память
+ * по Linux PSI (среднее "some" за 10 с из /proc/pressure/memory) или RSS процесса превышает порог
+ * Давление проверяется на медленных путях распределителей — при отображении нового блока и при переносе
+ * мест из кеша потока в блоки — после снятия блокировки распределителя и не чаще check_interval
+ * Без давления пустые блоки остаются в распределителе
+ * Ограничения: фонового потока нет — процесс, который не выделяет и не освобождает узлы, давление
+ * не проверяет; для него есть ReleaseNodeMemoryIfUnderPressure().
+ * Возврат памяти просит все потоки сбросить кеши, но блок, места которого лежат в кеше другого потока,
+ * станет пустым только после следующего обращения этого потока к распределителю или его завершения
+ */
+struct NodeMemoryPolicy
+{
+    // Порог доли времени в процентах, когда задачи ждут память; 0 — PSI не проверяется
+    double psi_some_avg10_limit = 10.0;
+    // Порог RSS процесса в байтах; 0 — RSS не проверяется
+    size_t rss_limit_bytes = 0;
+    // /proc читается не чаще этого интервала; между чтениями проверка давления стоит одного чтения часов
+    std::chrono::milliseconds check_interval{100};
+    // MADV_FREE вместо MADV_DONTNEED: дешевле, но ядро забирает страницы только при нехватке памяти
+    bool use_madv_free = false;
+};
+
+namespace node_arena_detail
+{
+    // Распределитель, умеющий вернуть системе пустые блоки
+    class Releasable
+    {
+        public:
+            virtual size_t ReleaseEmptySlabs(bool use_madv_free) noexcept = 0;
+
+        protected:
+            ~Releasable() = default;
+    };
+
+    // Общее для всех распределителей состояние: правила и список распределителей
+    class Registry
+    {
+        public:
+            static Registry& Instance()
+            {
+                // Намеренно не разрушается, как и сами распределители
+                static Registry* registry = new Registry();
+
+                return *registry;
+            }
+
+            void Add(Releasable* arena)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                arenas_.push_back(arena);
+            }
+
+            size_t ReleaseAll() noexcept
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                size_t released = 0;
+
+                for(Releasable* arena : arenas_)
+                {
+                    released += arena->ReleaseEmptySlabs(policy_.use_madv_free);
+                }
+
+                return released;
+            }
+
+            void SetPolicy(const NodeMemoryPolicy& policy)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                policy_ = policy;
+                // Новые правила действуют со следующей проверки, не дожидаясь прежнего интервала
+                next_check_ms_.store(0, std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] NodeMemoryPolicy GetPolicy()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                return policy_;
+            }
+
+            /*
+             * Сообщает, что память под давлением и пустые блоки пора вернуть системе
+             * /proc читается не чаще check_interval, в промежутках сразу возвращается false без блокировок,
+             * поэтому проверку можно делать на медленных путях распределителей
+             */
+            [[nodiscard]] bool IsUnderPressure() noexcept
+            {
+                const std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                std::int64_t next_check = next_check_ms_.load(std::memory_order_relaxed);
+
+                if(now < next_check)
+                {
+                    return false;
+                }
+
+                const NodeMemoryPolicy policy = GetPolicy();
+
+                if(!next_check_ms_.compare_exchange_strong(next_check, now + policy.check_interval.count(),
+                                                           std::memory_order_relaxed))
+                {
+                    return false;
+                }
+
+                return (policy.psi_some_avg10_limit > 0 && ReadPsiSomeAvg10() > policy.psi_some_avg10_limit)
+                       || (policy.rss_limit_bytes != 0 && ReadRssBytes() > policy.rss_limit_bytes);
+            }
+
+            // Проверяет давление и при нём возвращает пустые блоки. Вызывающий не должен держать блокировку распределителя
+            size_t ReleaseIfUnderPressure() noexcept
+            {
+                return IsUnderPressure() ? ReleaseAll() : 0;
+            }
+
+        private:
+            Registry() = default;
+
+            // avg10 строки "some" из /proc/pressure/memory; 0, если PSI недоступен
+            static double ReadPsiSomeAvg10() noexcept
+            {
+                std::FILE* file = std::fopen("/proc/pressure/memory", "r");
+
+                if(file == nullptr)
+                {
+                    return 0;
+                }
+
+                double avg10 = 0;
+
+                if(std::fscanf(file, "some avg10=%lf", &avg10) != 1)
+                {
+                    avg10 = 0;
+                }
+
+                std::fclose(file);
+
+                return avg10;
+            }
+
+            // Резидентный размер процесса из /proc/self/statm; 0, если он недоступен
+            static size_t ReadRssBytes() noexcept
+            {
+                std::FILE* file = std::fopen("/proc/self/statm", "r");
+
+                if(file == nullptr)
+                {
+                    return 0;
+                }
+
+                unsigned long size = 0;
+                unsigned long resident = 0;
+
+                if(std::fscanf(file, "%lu %lu", &size, &resident) != 2)
+                {
+                    resident = 0;
+                }
+
+                std::fclose(file);
+
+                return static_cast<size_t>(resident) * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            }
+
+            std::mutex mutex_;
+            std::vector<Releasable*> arenas_;
+            NodeMemoryPolicy policy_;
+            // Время, до которого /proc не читается
+            std::atomic<std::int64_t> next_check_ms_{0};
+    };
+}
+
+inline void SetNodeMemoryPolicy(const NodeMemoryPolicy& policy)
+{
+    node_arena_detail::Registry::Instance().SetPolicy(policy);
+}
+
+[[nodiscard]] inline NodeMemoryPolicy GetNodeMemoryPolicy()
+{
+    return node_arena_detail::Registry::Instance().GetPolicy();
+}
+
+// Возвращает системе память пустых блоков всех распределителей узлов. Возвращает число этих блоков
+inline size_t ReleaseNodeMemory() noexcept
+{
+    return node_arena_detail::Registry::Instance().ReleaseAll();
+}
+
+/*
+ * То же, что ReleaseNodeMemory(), но только если память под давлением по правилам NodeMemoryPolicy
+ * Распределители проверяют давление сами, пока выделяют и освобождают узлы; функция нужна процессу,
+ * который долго этого не делает, — например, для вызова из цикла событий. Чаще check_interval /proc не читается
+ */
+inline size_t ReleaseNodeMemoryIfUnderPressure() noexcept
+{
+    return node_arena_detail::Registry::Instance().ReleaseIfUnderPressure();
+}
+
+/*
+ * Распределитель узлов одного размера (size class) из блоков (slab) по 64 КиБ
+ * Каждый узел занимает ровно Size байт с выравниванием Align, без служебного заголовка и без
+ * округления до классов размеров malloc. Блок выровнен по своему размеру, поэтому блок, которому
+ * принадлежит узел, находится по адресу узла без поиска
+ * Для каждого сочетания Size и Align в процессе один распределитель, общий для всех списков
+ * Освобождённые узлы возвращаются в свой блок и используются повторно. Память блоков без живых
+ * узлов возвращается системе через madvise по правилам NodeMemoryPolicy: адреса блока остаются
+ * за распределителем, в памяти остаётся только страница с заголовком. Давление на память
+ * проверяется на медленных путях после снятия блокировки, поэтому возврат берёт её заново
+ * Перед блоками стоит кеш потока на несколько десятков мест: выделение и освобождение берут
+ * блокировку распределителя, только когда кеш пуст или полон, и переносят места пачкой.
+ * Кеш возвращается в блоки при завершении потока и по FlushThreadCaches(), которую вызывает
+ * и возврат памяти системе
+ */
+template <size_t Size, size_t Align>
+class NodeArena : private node_arena_detail::Releasable
+{
+    public:
+        static constexpr size_t kSlabSize = 64 * 1024;
+
+        // Статистика для оценки занимаемой памяти
+        struct Stats
+        {
+            size_t slab_count = 0;
+            // Узлы, выданные пользователям; места в кешах потоков сюда не входят
+            size_t live_count = 0;
+            // Байт, запрошенных у системы под блоки
+            size_t reserved_bytes = 0;
+            // Блоки без живых узлов, ещё занимающие память
+            size_t empty_slab_count = 0;
+            // Блоки, память которых возвращена системе
+            size_t released_slab_count = 0;
+            // Свободные места в кешах потоков: они не живые, но держат свои блоки непустыми
+            size_t cached_count = 0;
+        };
+
+        // Узлы такого размера не помещаются в блок с разумными потерями и выделяются через operator new
+        static constexpr bool kSupported = Size <= kSlabSize / 16 && Align <= 4096;
+
+        static NodeArena& Instance()
+        {
+            // Намеренно не разрушается: узлы статических списков могут освобождаться после выхода из main
+            static NodeArena* arena = Create();
+
+            return *arena;
+        }
+
+        NodeArena(const NodeArena&) = delete;
+        NodeArena& operator=(const NodeArena&) = delete;
+
+        [[nodiscard]] void* Allocate()
+        {
+            ThreadCache& cache = LocalCache();
+
+            if(cache.head != nullptr)
+            {
+                return PopCached(cache);
+            }
+
+            void* slot;
+            bool slab_created;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const size_t slab_count = slab_count_;
+                slot = AllocateLocked();
+
+                // Кеш заполняется местами из того же блока, чтобы следующие выделения обошлись без блокировки
+                if(cache.state == CacheState::Active)
+                {
+                    for(size_t i = 1; i < kCacheBatch && partial_ != nullptr; ++i)
+                    {
+                        PushCached(cache, AllocateLocked());
+                    }
+                }
+
+                slab_created = slab_count_ != slab_count;
+            }
+
+            // Новый блок увеличивает память процесса — повод вернуть пустые блоки других распределителей
+            if(slab_created)
+            {
+                node_arena_detail::Registry::Instance().ReleaseIfUnderPressure();
+            }
+
+            return slot;
+        }
+
+        void Deallocate(void* pointer) noexcept
+        {
+            ThreadCache& cache = LocalCache();
+
+            if(cache.state == CacheState::Active)
+            {
+                const bool flush = cache.count.load(std::memory_order_relaxed) == kCacheLimit;
+
+                if(flush)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    FlushLocked(cache, kCacheBatch);
+                }
+
+                PushCached(cache, pointer);
+
+                if(flush)
+                {
+                    node_arena_detail::Registry::Instance().ReleaseIfUnderPressure();
+                }
+
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            Release(pointer);
+        }
+
+        // Освобождает count узлов: сколько поместится — в кеш потока, остальные — за один захват блокировки
+        void DeallocateBatch(void* const* pointers, size_t count) noexcept
+        {
+            ThreadCache& cache = LocalCache();
+            size_t i = 0;
+
+            if(cache.state == CacheState::Active)
+            {
+                for(; i < count && cache.count.load(std::memory_order_relaxed) < kCacheLimit; ++i)
+                {
+                    PushCached(cache, pointers[i]);
+                }
+            }
+
+            if(i == count)
+            {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                for(; i < count; ++i)
+                {
+                    Release(pointers[i]);
+                }
+            }
+
+            node_arena_detail::Registry::Instance().ReleaseIfUnderPressure();
+        }
+
+        // Возвращает системе память пустых блоков этого распределителя. Возвращает число этих блоков
+        size_t ReleaseMemory() noexcept
+        {
+            return ReleaseEmptySlabs(GetNodeMemoryPolicy().use_madv_free);
+        }
+
+        /*
+         * Возвращает в блоки места из кешей всех потоков: кеш вызывающего потока — сразу,
+         * кеш другого потока — при его следующем выделении или освобождении узла
+         */
+        void FlushThreadCaches() noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            FlushThreadCachesLocked();
+        }
+
+        // Кеши потоков не трогает: места в них учитываются в cached_count, а не в live_count
+        [[nodiscard]] Stats GetStats()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t cached_count = 0;
+
+            for(const ThreadCache* cache = caches_; cache != nullptr; cache = cache->next)
+            {
+                cached_count += cache->count.load(std::memory_order_relaxed);
+            }
+
+            // Счётчики кешей читаются не одновременно, и место, перешедшее между кешами, может быть учтено дважды
+            cached_count = std::min(cached_count, live_count_);
+
+            Stats stats;
+            stats.slab_count = slab_count_;
+            stats.live_count = live_count_ - cached_count;
+            stats.reserved_bytes = slab_count_ * kSlabSize;
+            stats.empty_slab_count = empty_count_;
+            stats.released_slab_count = released_count_;
+            stats.cached_count = cached_count;
+
+            return stats;
+        }
+
+    private:
+        struct FreeSlot
+        {
+            FreeSlot* next;
+        };
+
+        enum class CacheState : unsigned char
+        {
+            // Поток ещё не обращался к распределителю
+            Unused,
+            Active,
+            // Поток завершается, кеш уже возвращён в блоки; дальше места освобождаются сразу в блоки
+            Closed
+        };
+
+        /*
+         * Кеш свободных мест одного потока для одного распределителя
+         * Тривиально разрушаем, поэтому остаётся доступным и после сброса при завершении потока —
+         * например, когда узлы статических списков освобождаются после выхода из main
+         * Меняет кеш только его поток; count атомарен, чтобы GetStats() мог читать его из другого потока
+         */
+        struct ThreadCache
+        {
+            FreeSlot* head = nullptr;
+            std::atomic<size_t> count{0};
+            CacheState state = CacheState::Unused;
+            // Номер последнего учтённого запроса на сброс кешей
+            std::uint64_t flush_epoch = 0;
+            // Соседи в списке активных кешей распределителя
+            ThreadCache* prev = nullptr;
+            ThreadCache* next = nullptr;
+        };
+
+        // При завершении потока возвращает места его кеша в блоки
+        struct CacheFlusher
+        {
+            ~CacheFlusher()
+            {
+                NodeArena& arena = Instance();
+                ThreadCache& cache = CacheStorage();
+                std::lock_guard<std::mutex> lock(arena.mutex_);
+                arena.FlushLocked(cache, cache.count.load(std::memory_order_relaxed));
+                arena.UnlinkCache(cache);
+                cache.state = CacheState::Closed;
+            }
+        };
+
+        static ThreadCache& CacheStorage() noexcept
+        {
+            static thread_local ThreadCache cache;
+
+            return cache;
+        }
+
+        /*
+         * Кеш вызывающего потока. Блокировка берётся, только если с прошлого обращения потока
+         * запрошен сброс кешей — тогда кеш возвращается в блоки — или поток обращается впервые
+         * Номер запроса у нового кеша 0, а у распределителя начинается с 1, поэтому первое обращение
+         * тоже идёт этим путём
+         */
+        ThreadCache& LocalCache() noexcept
+        {
+            ThreadCache& cache = CacheStorage();
+            const std::uint64_t flush_epoch = flush_epoch_.load(std::memory_order_relaxed);
+
+            if(cache.flush_epoch != flush_epoch)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                if(cache.state == CacheState::Unused)
+                {
+                    static thread_local CacheFlusher flusher;
+                    (void)flusher;
+                    cache.state = CacheState::Active;
+                    LinkCache(cache);
+                }
+                else
+                {
+                    FlushLocked(cache, cache.count.load(std::memory_order_relaxed));
+                }
+
+                cache.flush_epoch = flush_epoch;
+            }
+
+            return cache;
+        }
+
+        static void PushCached(ThreadCache& cache, void* pointer) noexcept
+        {
+            FreeSlot* slot = static_cast<FreeSlot*>(pointer);
+            slot->next = cache.head;
+            cache.head = slot;
+            cache.count.store(cache.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            NODE_ARENA_POISON(slot, kSlotSize);
+        }
+
+        static void* PopCached(ThreadCache& cache) noexcept
+        {
+            FreeSlot* slot = cache.head;
+            NODE_ARENA_UNPOISON(slot, sizeof(FreeSlot));
+            cache.head = slot->next;
+            cache.count.store(cache.count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            NODE_ARENA_UNPOISON(slot, kSlotSize);
+
+            return slot;
+        }
+
+        // Возвращает в блоки count мест из кеша. Вызывается под блокировкой
+        void FlushLocked(ThreadCache& cache, size_t count) noexcept
+        {
+            for(; count > 0; --count)
+            {
+                Release(PopCached(cache));
+            }
+        }
+
+        // Сбрасывает кеш вызывающего потока и просит остальные потоки сбросить свои. Вызывается под блокировкой
+        void FlushThreadCachesLocked() noexcept
+        {
+            const std::uint64_t flush_epoch = flush_epoch_.load(std::memory_order_relaxed) + 1;
+            flush_epoch_.store(flush_epoch, std::memory_order_relaxed);
+            ThreadCache& cache = CacheStorage();
+
+            if(cache.state == CacheState::Active)
+            {
+                FlushLocked(cache, cache.count.load(std::memory_order_relaxed));
+                cache.flush_epoch = flush_epoch;
+            }
+        }
+
+        // Списки активных кешей меняются под блокировкой
+        void LinkCache(ThreadCache& cache) noexcept
+        {
+            cache.prev = nullptr;
+            cache.next = caches_;
+
+            if(caches_ != nullptr)
+            {
+                caches_->prev = &cache;
+            }
+
+            caches_ = &cache;
+        }
+
+        void UnlinkCache(ThreadCache& cache) noexcept
+        {
+            if(cache.prev != nullptr)
+            {
+                cache.prev->next = cache.next;
+            }
+            else
+            {
+                caches_ = cache.next;
+            }
+
+            if(cache.next != nullptr)
+            {
+                cache.next->prev = cache.prev;
+            }
+
+            cache.prev = nullptr;
+            cache.next = nullptr;
+        }
+
+        // Выдаёт место из блоков. Вызывается под блокировкой
+        // Исключение возможно, только если частично занятых блоков нет
+        void* AllocateLocked()
+        {
+            // Частично занятые блоки заполняются первыми, затем пустые, затем возвращённые системе
+            if(partial_ == nullptr)
+            {
+                if(empty_ != nullptr)
+                {
+                    Slab* slab = empty_;
+                    Unlink(empty_, slab);
+                    --empty_count_;
+                    Link(partial_, slab);
+                }
+                else if(released_ != nullptr)
+                {
+                    Slab* slab = released_;
+                    Unlink(released_, slab);
+                    --released_count_;
+                    Link(partial_, slab);
+                }
+                else
+                {
+                    Link(partial_, CreateSlab());
+                }
+            }
+
+            Slab* slab = partial_;
+            void* slot;
+
+            if(slab->free_list != nullptr)
+            {
+                slot = slab->free_list;
+                NODE_ARENA_UNPOISON(slot, sizeof(FreeSlot));
+                slab->free_list = slab->free_list->next;
+            }
+            else
+            {
+                slot = reinterpret_cast<char*>(slab) + kFirstSlot + slab->carved_count * kSlotSize;
+                ++slab->carved_count;
+            }
+
+            NODE_ARENA_UNPOISON(slot, kSlotSize);
+            ++slab->live_count;
+            ++live_count_;
+
+            if(slab->live_count == kCapacity)
+            {
+                Unlink(partial_, slab);
+            }
+
+            return slot;
+        }
+
+        // Заголовок блока, расположенный в его начале
+        struct Slab
+        {
+            // Соседи в списке блоков, в котором находится блок; заполненный блок не входит ни в один
+            Slab* prev = nullptr;
+            Slab* next = nullptr;
+            FreeSlot* free_list = nullptr;
+            size_t live_count = 0;
+            // Сколько мест с начала блока уже выдавалось; дальше блок ещё не тронут
+            size_t carved_count = 0;
+        };
+
+        static constexpr size_t RoundUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        static constexpr size_t kSlotSize = RoundUp(Size < sizeof(FreeSlot) ? sizeof(FreeSlot) : Size, Align);
+        static constexpr size_t kFirstSlot = RoundUp(sizeof(Slab), Align);
+        static constexpr size_t kCapacity = (kSlabSize - kFirstSlot) / kSlotSize;
+        // Кеш потока занимает около 16 КиБ, но не больше 64 мест; места переносятся пачками по половине кеша
+        static constexpr size_t CacheLimit()
+        {
+            const size_t limit = 16 * 1024 / kSlotSize;
+
+            return limit < 2 ? 2 : limit > 64 ? 64 : limit;
+        }
+
+        static constexpr size_t kCacheLimit = CacheLimit();
+        static constexpr size_t kCacheBatch = kCacheLimit / 2;
+
+        static_assert(!kSupported || kCapacity >= 2, "size class does not fit into a slab");
+
+        NodeArena() = default;
+
+        static NodeArena* Create()
+        {
+            NodeArena* arena = new NodeArena();
+            node_arena_detail::Registry::Instance().Add(arena);
+
+            return arena;
+        }
+
+        static Slab* SlabOf(void* pointer) noexcept
+        {
+            return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(pointer) & ~static_cast<std::uintptr_t>(kSlabSize - 1));
+        }
+
+        // Возвращает место узла в его блок. Вызывается под блокировкой
+        void Release(void* pointer) noexcept
+        {
+            Slab* slab = SlabOf(pointer);
+            FreeSlot* slot = static_cast<FreeSlot*>(pointer);
+            slot->next = slab->free_list;
+            slab->free_list = slot;
+            // Под AddressSanitizer обращение к освобождённому узлу обнаруживается, как и с обычным delete
+            NODE_ARENA_POISON(slot, kSlotSize);
+
+            if(slab->live_count == kCapacity)
+            {
+                Link(partial_, slab);
+            }
+
+            --slab->live_count;
+            --live_count_;
+
+            if(slab->live_count == 0)
+            {
+                Unlink(partial_, slab);
+                Link(empty_, slab);
+                ++empty_count_;
+            }
+        }
+
+        // Отдаёт системе все страницы пустых блоков, кроме страницы с заголовком
+        // Содержимое мест после этого не нужно: блок заполняется заново с начала
+        size_t ReleaseEmptySlabs(bool use_madv_free) noexcept override
+        {
+            const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            std::lock_guard<std::mutex> lock(mutex_);
+            FlushThreadCachesLocked();
+            size_t released = 0;
+
+            while(empty_ != nullptr)
+            {
+                Slab* slab = empty_;
+                Unlink(empty_, slab);
+                --empty_count_;
+
+                ::madvise(reinterpret_cast<char*>(slab) + page_size, kSlabSize - page_size,
+                          use_madv_free ? MADV_FREE : MADV_DONTNEED);
+                slab->free_list = nullptr;
+                slab->carved_count = 0;
+
+                Link(released_, slab);
+                ++released_count_;
+                ++released;
+            }
+
+            return released;
+        }
+
+        // Отображает новый блок, выровненный по kSlabSize: берётся вдвое больший участок и лишнее возвращается
+        Slab* CreateSlab()
+        {
+            void* area = ::mmap(nullptr, 2 * kSlabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if(area == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+
+            const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(area);
+            const std::uintptr_t aligned = (begin + kSlabSize - 1) & ~static_cast<std::uintptr_t>(kSlabSize - 1);
+
+            if(aligned != begin)
+            {
+                ::munmap(area, aligned - begin);
+            }
+
+            ::munmap(reinterpret_cast<void*>(aligned + kSlabSize), begin + kSlabSize - aligned);
+
+            ++slab_count_;
+
+            return new(reinterpret_cast<void*>(aligned)) Slab();
+        }
+
+        static void Link(Slab*& list, Slab* slab) noexcept
+        {
+            slab->prev = nullptr;
+            slab->next = list;
+
+            if(list != nullptr)
+            {
+                list->prev = slab;
+            }
+
+            list = slab;
+        }
+
+        static void Unlink(Slab*& list, Slab* slab) noexcept
+        {
+            if(slab->prev != nullptr)
+            {
+                slab->prev->next = slab->next;
+            }
+            else
+            {
+                list = slab->next;
+            }
+
+            if(slab->next != nullptr)
+            {
+                slab->next->prev = slab->prev;
+            }
+
+            slab->prev = nullptr;
+            slab->next = nullptr;
+        }
+
+        std::mutex mutex_;
+        // Блоки, в которых есть и живые узлы, и свободные места
+        Slab* partial_ = nullptr;
+        // Блоки без живых узлов, ещё занимающие память
+        Slab* empty_ = nullptr;
+        // Блоки, память которых возвращена системе; их адреса используются повторно
+        Slab* released_ = nullptr;
+        size_t slab_count_ = 0;
+        size_t live_count_ = 0;
+        size_t empty_count_ = 0;
+        size_t released_count_ = 0;
+        // Активные кеши потоков, для GetStats()
+        ThreadCache* caches_ = nullptr;
+        // Номер запроса на сброс кешей; кеш, учтённый с меньшим номером, сбрасывается при следующем обращении потока
+        // Читается при каждом выделении, поэтому лежит в отдельной строке кеша, вдали от mutex_
+        alignas(64) std::atomic<std::uint64_t> flush_epoch_{1};
+};
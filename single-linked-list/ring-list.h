@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+// Кольцевой односвязный список: последний узел ссылается на первый
+// Список хранит указатель на последний узел, поэтому начало (текущий элемент кольца),
+// вставка в конец и поворот кольца выполняются за O(1)
+template <typename Type>
+class RingList
+{
+    struct Node
+    {
+        Node(const Type& val, Node* next) : value(val), next_node(next) {}
+
+        Type value;
+        Node* next_node = nullptr;
+    };
+
+    // Круг обхода, на котором находится итератор: позиция before_begin() стоит на последнем узле
+    // до начала обхода, а end() — на первом узле после его окончания
+    static constexpr int kBeforeBeginLap = -1;
+    static constexpr int kEndLap = 1;
+
+    template <typename ValueType>
+    class BasicIterator
+    {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = ValueType*;
+            using reference = ValueType&;
+
+            BasicIterator() = default;
+
+            // Конвертирующий конструктор/конструктор копирования
+            BasicIterator(const BasicIterator<Type>& other) noexcept
+                : node_(other.node_), prev_node_(other.prev_node_), last_node_(other.last_node_), lap_(other.lap_)
+            {
+            }
+
+            BasicIterator& operator=(const BasicIterator& rhs) = default;
+
+            // Итераторы равны, если ссылаются на один и тот же узел на одном и том же круге обхода
+            // Итератор end() ссылается на первый узел, но на следующем круге
+            [[nodiscard]] bool operator==(const BasicIterator<const Type>& rhs) const noexcept
+            {
+                return node_ == rhs.node_ && lap_ == rhs.lap_;
+            }
+
+            [[nodiscard]] bool operator!=(const BasicIterator<const Type>& rhs) const noexcept
+            {
+                return !(*this == rhs);
+            }
+
+            [[nodiscard]] bool operator==(const BasicIterator<Type>& rhs) const noexcept
+            {
+                return node_ == rhs.node_ && lap_ == rhs.lap_;
+            }
+
+            [[nodiscard]] bool operator!=(const BasicIterator<Type>& rhs) const noexcept
+            {
+                return !(*this == rhs);
+            }
+
+            // Переходит к следующему узлу кольца. Из before_begin() итератор переходит к begin(),
+            // а после последнего узла возвращается к первому и становится равен end()
+            BasicIterator& operator++() noexcept
+            {
+                assert(node_ != nullptr);
+
+                if(node_ == last_node_)
+                {
+                    ++lap_;
+                }
+
+                prev_node_ = node_;
+                node_ = node_->next_node;
+
+                return *this;
+            }
+
+            BasicIterator operator++(int) noexcept
+            {
+                auto old_value(*this);
+                ++(*this);
+                return old_value;
+            }
+
+            [[nodiscard]] reference operator*() const noexcept
+            {
+                assert(node_ != nullptr);
+
+                return node_->value;
+            }
+
+            [[nodiscard]] pointer operator->() const noexcept
+            {
+                assert(node_ != nullptr);
+
+                return &(node_->value);
+            }
+
+        private:
+            Node* node_ = nullptr;
+            // Предыдущий узел кольца. Благодаря ему поворот кольца к итератору выполняется за O(1)
+            Node* prev_node_ = nullptr;
+            // Последний узел кольца на момент создания итератора — граница одного круга обхода
+            Node* last_node_ = nullptr;
+            int lap_ = 0;
+
+            friend class RingList;
+
+            BasicIterator(Node* node, Node* prev_node, Node* last_node, int lap = 0)
+                : node_(node), prev_node_(prev_node), last_node_(last_node), lap_(lap)
+            {
+            }
+    };
+
+    public:
+        using value_type = Type;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+
+        using Iterator = BasicIterator<Type>;
+        using ConstIterator = BasicIterator<const Type>;
+
+        RingList() = default;
+
+        RingList(std::initializer_list<Type> values)
+        {
+            for(const Type& value : values)
+            {
+                PushBack(value);
+            }
+        }
+
+        RingList(const RingList& other)
+        {
+            RingList tmp;
+
+            for(const Type& value : other)
+            {
+                tmp.PushBack(value);
+            }
+
+            swap(tmp);
+        }
+
+        RingList& operator=(const RingList& rhs)
+        {
+            if(this != &rhs)
+            {
+                RingList tmp(rhs);
+                swap(tmp);
+            }
+
+            return *this;
+        }
+
+        ~RingList()
+        {
+            Clear();
+        }
+
+        // Обменивает содержимое колец за время O(1)
+        void swap(RingList& other) noexcept
+        {
+            std::swap(last_node_, other.last_node_);
+            std::swap(size_, other.size_);
+        }
+
+        // Возвращает итератор на текущий (первый) элемент кольца
+        // Обход от begin() до end() проходит кольцо ровно один раз
+        [[nodiscard]] Iterator begin() noexcept
+        {
+            return last_node_ == nullptr ? Iterator{} : Iterator{last_node_->next_node, last_node_, last_node_};
+        }
+
+        [[nodiscard]] Iterator end() noexcept
+        {
+            return last_node_ == nullptr ? Iterator{} : Iterator{last_node_->next_node, last_node_, last_node_, kEndLap};
+        }
+
+        [[nodiscard]] ConstIterator begin() const noexcept
+        {
+            return cbegin();
+        }
+
+        [[nodiscard]] ConstIterator end() const noexcept
+        {
+            return cend();
+        }
+
+        [[nodiscard]] ConstIterator cbegin() const noexcept
+        {
+            return last_node_ == nullptr ? ConstIterator{} : ConstIterator{last_node_->next_node, last_node_, last_node_};
+        }
+
+        [[nodiscard]] ConstIterator cend() const noexcept
+        {
+            return last_node_ == nullptr ? ConstIterator{} : ConstIterator{last_node_->next_node, last_node_, last_node_, kEndLap};
+        }
+
+        // Возвращает итератор на последний элемент кольца — позицию перед текущим элементом
+        // Вставка после него добавляет элемент в начало кольца, удаление после него — удаляет текущий элемент
+        // Как и у списка, ++before_begin() == begin()
+        [[nodiscard]] Iterator before_begin() noexcept
+        {
+            assert(last_node_ != nullptr);
+
+            return Iterator{last_node_, nullptr, last_node_, kBeforeBeginLap};
+        }
+
+        [[nodiscard]] ConstIterator cbefore_begin() const noexcept
+        {
+            assert(last_node_ != nullptr);
+
+            return ConstIterator{last_node_, nullptr, last_node_, kBeforeBeginLap};
+        }
+
+        [[nodiscard]] size_t GetSize() const noexcept
+        {
+            return size_;
+        }
+
+        [[nodiscard]] bool IsEmpty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        // Текущий элемент кольца
+        [[nodiscard]] reference Current() noexcept
+        {
+            assert(last_node_ != nullptr);
+
+            return last_node_->next_node->value;
+        }
+
+        [[nodiscard]] const_reference Current() const noexcept
+        {
+            assert(last_node_ != nullptr);
+
+            return last_node_->next_node->value;
+        }
+
+        // Делает текущим следующий элемент кольца, а прежний текущий — последним
+        // Один шаг — одно перемещение указателя
+        void Advance(size_t steps = 1) noexcept
+        {
+            if(last_node_ == nullptr)
+            {
+                return;
+            }
+
+            for(steps %= size_; steps > 0; --steps)
+            {
+                last_node_ = last_node_->next_node;
+            }
+        }
+
+        // Делает текущим элемент, на который указывает pos
+        // За O(1), если предыдущий элемент, запомненный в pos, всё ещё предыдущий (см. PrevOf), иначе за O(n)
+        void RotateTo(ConstIterator pos) noexcept
+        {
+            last_node_ = PrevOf(pos);
+        }
+
+        // Вставляет элемент перед текущим — он будет обслужен последним в круге
+        void PushBack(const Type& value)
+        {
+            last_node_ = InsertNode(value);
+        }
+
+        // Вставляет элемент перед текущим и делает его текущим
+        void PushFront(const Type& value)
+        {
+            InsertNode(value);
+        }
+
+        // Удаляет текущий элемент. Текущим становится следующий
+        void PopFront() noexcept
+        {
+            assert(last_node_ != nullptr);
+
+            EraseAfter(cbefore_begin());
+        }
+
+        // Вставляет элемент value после pos за время O(1) и возвращает итератор на него
+        // Вставка после последнего элемента круга делает новый элемент последним, а вставка
+        // после before_begin() — текущим
+        // Если при создании элемента будет выброшено исключение, кольцо останется в прежнем состоянии
+        Iterator InsertAfter(ConstIterator pos, const Type& value)
+        {
+            assert(pos.node_ != nullptr);
+
+            Node* new_node = new Node(value, pos.node_->next_node);
+            pos.node_->next_node = new_node;
+            ++size_;
+
+            if(pos.node_ == last_node_ && pos.lap_ != kBeforeBeginLap)
+            {
+                last_node_ = new_node;
+            }
+
+            return Iterator{new_node, pos.node_, last_node_};
+        }
+
+        // Удаляет элемент, следующий за pos, за время O(1)
+        // Возвращает итератор на элемент, следующий за удалённым, либо end(), если кольцо опустело
+        // или удалён последний элемент круга
+        Iterator EraseAfter(ConstIterator pos) noexcept
+        {
+            assert(pos.node_ != nullptr);
+
+            Node* node_for_del = pos.node_->next_node;
+            --size_;
+
+            if(node_for_del == pos.node_)
+            {
+                last_node_ = nullptr;
+                delete node_for_del;
+
+                return end();
+            }
+
+            pos.node_->next_node = node_for_del->next_node;
+
+            const bool was_last = node_for_del == last_node_;
+            delete node_for_del;
+
+            if(was_last)
+            {
+                last_node_ = pos.node_;
+
+                return end();
+            }
+
+            return Iterator{pos.node_->next_node, pos.node_, last_node_};
+        }
+
+        // Удаляет элемент, на который указывает pos. Время — как у RotateTo
+        Iterator Erase(ConstIterator pos) noexcept
+        {
+            return EraseAfter(ConstIterator{PrevOf(pos), nullptr, last_node_});
+        }
+
+        void Clear() noexcept
+        {
+            if(last_node_ == nullptr)
+            {
+                return;
+            }
+
+            Node* node = last_node_->next_node;
+            last_node_->next_node = nullptr;
+
+            while(node != nullptr)
+            {
+                Node* next_node = node->next_node;
+                delete node;
+                node = next_node;
+            }
+
+            last_node_ = nullptr;
+            size_ = 0;
+        }
+
+    private:
+        /*
+         * Возвращает узел, предшествующий pos. Итератор запоминает предыдущий узел, но вставка
+         * между ними делает его устаревшим — тогда предыдущий узел ищется обходом кольца
+         * Предыдущий узел, запомненный в pos, не должен быть удалён
+         */
+        Node* PrevOf(const ConstIterator& pos) const noexcept
+        {
+            assert(pos.node_ != nullptr);
+
+            Node* prev_node = pos.prev_node_;
+
+            if(prev_node == nullptr || prev_node->next_node != pos.node_)
+            {
+                prev_node = pos.node_;
+
+                while(prev_node->next_node != pos.node_)
+                {
+                    prev_node = prev_node->next_node;
+                }
+            }
+
+            return prev_node;
+        }
+
+        // Вставляет узел между последним и текущим узлами и возвращает его
+        Node* InsertNode(const Type& value)
+        {
+            if(last_node_ == nullptr)
+            {
+                Node* new_node = new Node(value, nullptr);
+                new_node->next_node = new_node;
+                last_node_ = new_node;
+                size_ = 1;
+
+                return new_node;
+            }
+
+            Node* new_node = new Node(value, last_node_->next_node);
+            last_node_->next_node = new_node;
+            ++size_;
+
+            return new_node;
+        }
+
+        // Последний узел кольца. Следующий за ним узел — текущий (первый) элемент
+        Node* last_node_ = nullptr;
+        size_t size_ = 0;
+};
+
+template <typename Type>
+void swap(RingList<Type>& lhs, RingList<Type>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template <typename Type>
+bool operator==(const RingList<Type>& lhs, const RingList<Type>& rhs)
+{
+    return lhs.GetSize() == rhs.GetSize() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename Type>
+bool operator!=(const RingList<Type>& lhs, const RingList<Type>& rhs)
+{
+    return !(lhs == rhs);
+}
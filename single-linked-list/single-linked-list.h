@@ -1,23 +1,248 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
+
+#include "frozen-list.h"
+#include "list-executor.h"
+#include "node-arena.h"
+
+/*
+ * Наблюдатель за изменениями списка (например, журнал изменений)
+ * Элементы передаются непрозрачными ключами — адресами их значений. Ключ не меняется, пока элемент
+ * находится в списке; позиции перед первым элементом соответствует nullptr
+ * Методы вызываются из noexcept-операций списка, поэтому сами не должны выбрасывать исключения
+ */
+template <typename Type>
+class SingleLinkedListObserver
+{
+    public:
+        virtual ~SingleLinkedListObserver() = default;
+
+        // Элемент element со значением value вставлен после элемента pos
+        virtual void OnInsert(const void* pos, const void* element, const Type& value) noexcept = 0;
+        // Элемент element удалён (физически либо логически)
+        virtual void OnErase(const void* element) noexcept = 0;
+        // Все элементы удалены
+        virtual void OnClear() noexcept = 0;
+        // Список изменился так, что изменение нельзя описать отдельными вставками и удалениями
+        // (перестановка элементов, обмен содержимым)
+        virtual void OnReset() noexcept = 0;
+        // Начата, подтверждена или отменена транзакция списка. Изменения внутри транзакции сообщаются
+        // как обычно; при отмене после OnTransactionRollback() вызывается OnReset()
+        virtual void OnTransactionBegin() noexcept {}
+        virtual void OnTransactionCommit() noexcept {}
+        virtual void OnTransactionRollback() noexcept {}
+};
+
+namespace single_linked_list_detail
+{
+    /*
+     * Указатель на следующий узел, в младшем бите которого хранится признак логически удалённого
+     * узла-владельца (tombstone). Узлы выровнены не меньше чем по указателю, поэтому младший бит адреса
+     * всегда нулевой, и признак не увеличивает узел
+     * Присваивание меняет только адрес и сохраняет признак владельца
+     */
+    template <typename Node>
+    class TaggedNext
+    {
+        public:
+            TaggedNext() = default;
+
+            TaggedNext(Node* node) noexcept : bits_(reinterpret_cast<std::uintptr_t>(node))
+            {
+            }
+
+            TaggedNext(const TaggedNext& other) noexcept : bits_(other.bits_)
+            {
+            }
+
+            TaggedNext& operator=(Node* node) noexcept
+            {
+                bits_ = reinterpret_cast<std::uintptr_t>(node) | (bits_ & kErased);
+
+                return *this;
+            }
+
+            TaggedNext& operator=(const TaggedNext& other) noexcept
+            {
+                return *this = static_cast<Node*>(other);
+            }
+
+            operator Node*() const noexcept
+            {
+                return reinterpret_cast<Node*>(bits_ & ~kErased);
+            }
+
+            Node* operator->() const noexcept
+            {
+                return *this;
+            }
+
+            [[nodiscard]] bool IsErased() const noexcept
+            {
+                return (bits_ & kErased) != 0;
+            }
+
+            void SetErased(bool erased) noexcept
+            {
+                bits_ = (bits_ & ~kErased) | (erased ? kErased : 0);
+            }
+
+            // Чтение и запись адреса с упорядочиванием acquire/release для передачи узлов между потоками
+            [[nodiscard]] Node* LoadAcquire() const noexcept
+            {
+                return reinterpret_cast<Node*>(__atomic_load_n(&bits_, __ATOMIC_ACQUIRE) & ~kErased);
+            }
+
+            void StoreRelease(Node* node) noexcept
+            {
+                __atomic_store_n(&bits_, reinterpret_cast<std::uintptr_t>(node) | (bits_ & kErased), __ATOMIC_RELEASE);
+            }
+
+        private:
+            static constexpr std::uintptr_t kErased = 1;
+
+            std::uintptr_t bits_ = 0;
+    };
+
+    /*
+     * Поля узла списка в порядке, при котором узел меньше всего. Если значение выровнено не строже
+     * указателя, указатель ставится первым, иначе первым идёт значение, чтобы перед ним не было заполнения
+     * Признак логически удалённого узла хранится в указателе next_node и места не занимает:
+     * узел SingleLinkedList<int64_t> занимает 16 байт, как узел {value, next} без признака
+     */
+    template <typename Type, typename Node, bool LinkFirst = alignof(Type) <= alignof(Node*)>
+    struct NodeFields
+    {
+        NodeFields() = default;
+
+        NodeFields(const Type& val, Node* next) : next_node(next), value(val) {}
+
+        NodeFields(Type&& val, Node* next) : next_node(next), value(std::move(val)) {}
+
+        TaggedNext<Node> next_node = nullptr;
+        Type value;
+    };
+
+    template <typename Type, typename Node>
+    struct NodeFields<Type, Node, false>
+    {
+        NodeFields() = default;
+
+        NodeFields(const Type& val, Node* next) : value(val), next_node(next) {}
+
+        NodeFields(Type&& val, Node* next) : value(std::move(val)), next_node(next) {}
+
+        Type value;
+        TaggedNext<Node> next_node = nullptr;
+    };
+}
 
 template <typename Type>
 class SingleLinkedList 
 {
-    struct Node
+    struct Node : single_linked_list_detail::NodeFields<Type, Node>
     {
-        Node() = default;
+        using single_linked_list_detail::NodeFields<Type, Node>::NodeFields;
 
-        Node(const Type& val, Node* next) : value(val), next_node(next) {}
+        // Узлы выделяются из блоков точного размера, общих для всех списков с узлами этого размера
+        static void* operator new(size_t size)
+        {
+            assert(size == sizeof(Node));
 
-        Type value;
-        Node* next_node = nullptr;
+            if constexpr(Arena::kSupported)
+            {
+                return Arena::Instance().Allocate();
+            }
+            else
+            {
+                return ::operator new(size);
+            }
+        }
+
+        static void operator delete(void* pointer) noexcept
+        {
+            if constexpr(Arena::kSupported)
+            {
+                Arena::Instance().Deallocate(pointer);
+            }
+            else
+            {
+                ::operator delete(pointer);
+            }
+        }
+
+        // Возвращает распределителю память count узлов, деструкторы которых уже вызваны, одним пакетом
+        static void DeallocateBatch(Node* const* nodes, size_t count) noexcept
+        {
+            if constexpr(Arena::kSupported)
+            {
+                Arena::Instance().DeallocateBatch(reinterpret_cast<void* const*>(nodes), count);
+            }
+            else
+            {
+                for(size_t i = 0; i < count; ++i)
+                {
+                    ::operator delete(nodes[i]);
+                }
+            }
+        }
+
+        // Уничтожает count узлов и возвращает их память распределителю одним пакетом
+        static void DestroyBatch(Node* const* nodes, size_t count) noexcept
+        {
+            for(size_t i = 0; i < count; ++i)
+            {
+                nodes[i]->~Node();
+            }
+
+            DeallocateBatch(nodes, count);
+        }
+
+        // Признак логически удалённого узла (tombstone). Такие узлы пропускаются итераторами
+        // и освобождаются методом Compact()
+        [[nodiscard]] bool IsErased() const noexcept
+        {
+            return this->next_node.IsErased();
+        }
+
+        void SetErased(bool erased) noexcept
+        {
+            this->next_node.SetErased(erased);
+        }
+
+        // Возвращает первый не удалённый логически узел, начиная с node, либо nullptr
+        static Node* SkipErased(Node* node) noexcept
+        {
+            while(node != nullptr && node->IsErased())
+            {
+                node = node->next_node;
+            }
+
+            return node;
+        }
     };
 
+    // Очередь строится на узлах списка и освобождает их так же, как список
+    template <typename> friend class SpscQueue;
+
+    public:
+        // Распределитель узлов списка
+        using Arena = NodeArena<sizeof(Node), alignof(Node)>;
+
+    private:
     template <typename ValueType>
     class BasicIterator
     {
@@ -80,13 +305,14 @@ class SingleLinkedList
             }
 
             // Оператор прединкремента. После его вызова итератор указывает на следующий элемент списка
+            // Логически удалённые элементы пропускаются
             // Возвращает ссылку на самого себя
             // Инкремент итератора, не указывающего на существующий элемент списка, приводит к неопределённому поведению
             BasicIterator& operator++() noexcept
             {
                 if(node_ != nullptr)
                 {
-                    node_ = node_->next_node;
+                    node_ = Node::SkipErased(node_->next_node);
                 }
 
                 return *this;
@@ -144,11 +370,147 @@ class SingleLinkedList
         // Константный итератор, предоставляющий доступ для чтения к элементам списка
         using ConstIterator = BasicIterator<const Type>;
 
+        /*
+         * Устойчивый курсор. В отличие от итератора, курсор зарегистрирован в списке и не становится
+         * недействительным при удалении элемента, на который он указывает: список переводит его
+         * на следующий элемент. Поэтому прерванный обход можно продолжить с того же места
+         * Курсоры списка хранятся в интрузивном двусвязном реестре; удаление элемента обходит реестр,
+         * только если в нём есть курсоры
+         */
+        class Cursor
+        {
+            public:
+                Cursor() = default;
+
+                // Копия курсора указывает на тот же элемент и регистрируется в том же списке
+                Cursor(const Cursor& other) noexcept
+                {
+                    Attach(other.list_, other.node_);
+                }
+
+                Cursor& operator=(const Cursor& rhs) noexcept
+                {
+                    if(this != &rhs)
+                    {
+                        Detach();
+                        Attach(rhs.list_, rhs.node_);
+                    }
+
+                    return *this;
+                }
+
+                ~Cursor()
+                {
+                    Detach();
+                }
+
+                // Сообщает, что курсор привязан к существующему списку
+                [[nodiscard]] bool IsAttached() const noexcept
+                {
+                    return list_ != nullptr;
+                }
+
+                // Сообщает, что курсор вышел за последний элемент списка
+                [[nodiscard]] bool AtEnd() const noexcept
+                {
+                    return node_ == nullptr;
+                }
+
+                [[nodiscard]] reference operator*() const noexcept
+                {
+                    assert(node_ != nullptr);
+
+                    return node_->value;
+                }
+
+                [[nodiscard]] Type* operator->() const noexcept
+                {
+                    assert(node_ != nullptr);
+
+                    return &(node_->value);
+                }
+
+                // Переводит курсор на следующий элемент списка, пропуская логически удалённые
+                Cursor& operator++() noexcept
+                {
+                    if(node_ != nullptr)
+                    {
+                        node_ = Node::SkipErased(node_->next_node);
+                    }
+
+                    return *this;
+                }
+
+                // Возвращает обычный итератор на элемент, на который указывает курсор
+                [[nodiscard]] Iterator GetIterator() const noexcept
+                {
+                    return Iterator{node_};
+                }
+
+            private:
+                SingleLinkedList* list_ = nullptr;
+                Node* node_ = nullptr;
+                Cursor* prev_cursor_ = nullptr;
+                Cursor* next_cursor_ = nullptr;
+
+                friend class SingleLinkedList;
+
+                Cursor(SingleLinkedList* list, Node* node) noexcept
+                {
+                    Attach(list, node);
+                }
+
+                void Attach(SingleLinkedList* list, Node* node) noexcept
+                {
+                    list_ = list;
+                    node_ = node;
+
+                    if(list_ != nullptr)
+                    {
+                        next_cursor_ = list_->cursors_;
+
+                        if(next_cursor_ != nullptr)
+                        {
+                            next_cursor_->prev_cursor_ = this;
+                        }
+
+                        list_->cursors_ = this;
+                    }
+                }
+
+                void Detach() noexcept
+                {
+                    if(list_ == nullptr)
+                    {
+                        return;
+                    }
+
+                    if(prev_cursor_ != nullptr)
+                    {
+                        prev_cursor_->next_cursor_ = next_cursor_;
+                    }
+                    else
+                    {
+                        list_->cursors_ = next_cursor_;
+                    }
+
+                    if(next_cursor_ != nullptr)
+                    {
+                        next_cursor_->prev_cursor_ = prev_cursor_;
+                    }
+
+                    list_ = nullptr;
+                    node_ = nullptr;
+                    prev_cursor_ = nullptr;
+                    next_cursor_ = nullptr;
+                }
+        };
+
         // Возвращает итератор, ссылающийся на первый элемент
         // Если список пустой, возвращённый итератор будет равен end()
         [[nodiscard]] Iterator begin() noexcept
         {
-            return Iterator{head_.next_node};
+            return Iterator{Node::SkipErased(head_.next_node)};
         }
 
         // Возвращает итератор, указывающий на позицию, следующую за последним элементом односвязного списка
@@ -163,7 +525,7 @@ class SingleLinkedList
         // Результат вызова эквивалентен вызову метода cbegin()
         [[nodiscard]] ConstIterator begin() const noexcept
         {
-            return ConstIterator{head_.next_node};
+            return ConstIterator{Node::SkipErased(head_.next_node)};
         }
 
         // Возвращает константный итератор, указывающий на позицию, следующую за последним элементом односвязного списка
@@ -178,7 +540,7 @@ class SingleLinkedList
         // Если список пустой, возвращённый итератор будет равен cend()
         [[nodiscard]] ConstIterator cbegin() const noexcept
         {
-            return ConstIterator{head_.next_node};
+            return ConstIterator{Node::SkipErased(head_.next_node)};
         }
 
         // Возвращает константный итератор, указывающий на позицию, следующую за последним элементом односвязного списка
@@ -216,28 +578,109 @@ class SingleLinkedList
          */
         Iterator InsertAfter(ConstIterator pos, const Type& value)
         {
-            assert(pos.node_ != nullptr);
-            
-            Node* new_node = new Node(value, pos.node_->next_node);
-            pos.node_->next_node = new_node;
-            ++size_;
+            return InsertNodeAfter(pos.node_, value);
+        }
 
-            return Iterator{new_node};
+        // Вставляет элемент value после pos, перемещая значение в узел
+        Iterator InsertAfter(ConstIterator pos, Type&& value)
+        {
+            return InsertNodeAfter(pos.node_, std::move(value));
         }
 
         /*
-         * Удаляет элемент, следующий за pos.
+         * Удаляет элемент, следующий за pos. Логически удалённые узлы между ними остаются на месте
          * Возвращает итератор на элемент, следующий за удалённым
          */
         Iterator EraseAfter(ConstIterator pos) noexcept
         {
             assert(pos.node_ != nullptr);
-            
-            Node* node_for_del = pos.node_->next_node;
-            pos.node_->next_node = pos.node_->next_node->next_node;
-            delete node_for_del;
 
-            return Iterator{pos.node_->next_node};
+            Node* prev_node = pos.node_;
+
+            while(prev_node->next_node->IsErased())
+            {
+                prev_node = prev_node->next_node;
+            }
+
+            Node* node_for_del = prev_node->next_node;
+            SetNext(prev_node, node_for_del->next_node);
+            MoveCursors(node_for_del, Node::SkipErased(node_for_del->next_node));
+            NotifyErase(node_for_del);
+            DestroyNode(node_for_del);
+            --size_;
+
+            return Iterator{Node::SkipErased(prev_node->next_node)};
+        }
+
+        /*
+         * Переносит все узлы списка other за элемент pos без копирования значений; other становится пустым
+         * other_last должен указывать на последний узел other — его знает тот, кто строил other,
+         * поэтому перенос выполняется за O(1) без прохода по other
+         * Проход по перенесённым узлам нужен, только если у списка есть наблюдатель или активна транзакция
+         * Курсоры other переходят в этот список вместе со своими элементами
+         * Возвращает итератор на последний перенесённый узел либо pos, если other пуст
+         */
+        Iterator SpliceAfter(ConstIterator pos, SingleLinkedList&& other, ConstIterator other_last)
+        {
+            assert(pos.node_ != nullptr && this != &other);
+            assert(other.transaction_ == nullptr);
+
+            Node* first_node = other.head_.next_node;
+
+            if(first_node == nullptr)
+            {
+                return Iterator{pos.node_};
+            }
+
+            assert(other_last.node_ != nullptr && other_last.node_->next_node == nullptr);
+
+            if(transaction_ != nullptr)
+            {
+                ReserveUndo(1, other.size_ + other.erased_count_);
+
+                for(Node* node = first_node; node != nullptr; node = node->next_node)
+                {
+                    RecordInserted(node);
+                }
+            }
+
+            if(other.observer_ != nullptr)
+            {
+                other.observer_->OnClear();
+            }
+
+            while(other.cursors_ != nullptr)
+            {
+                Cursor* cursor = other.cursors_;
+                Node* node = cursor->node_;
+                cursor->Detach();
+                cursor->Attach(this, node);
+            }
+
+            other_last.node_->next_node = pos.node_->next_node;
+            SetNext(pos.node_, first_node);
+            size_ += other.size_;
+            erased_count_ += other.erased_count_;
+
+            other.head_.next_node = nullptr;
+            other.size_ = 0;
+            other.erased_count_ = 0;
+
+            if(observer_ != nullptr)
+            {
+                Node* prev_node = pos.node_;
+
+                for(Node* node = first_node; node != other_last.node_->next_node; node = node->next_node)
+                {
+                    if(!node->IsErased())
+                    {
+                        NotifyInsert(prev_node, node);
+                        prev_node = node;
+                    }
+                }
+            }
+
+            return Iterator{other_last.node_};
         }
 
         SingleLinkedList() : head_(), size_()
@@ -258,14 +701,15 @@ class SingleLinkedList
         {
             SingleLinkedList tmp;
 
-            Node* other_next_node = other.head_.next_node;
+            // Логически удалённые элементы не копируются
+            Node* other_next_node = Node::SkipErased(other.head_.next_node);
 
-            if(other.head_.next_node != nullptr)
+            if(other_next_node != nullptr)
             {
                 Node* first_node = new Node(other_next_node->value, nullptr);
                 tmp.head_.next_node = first_node;
 
-                other_next_node = other_next_node->next_node;
+                other_next_node = Node::SkipErased(other_next_node->next_node);
                 Node* prev_node = first_node;
 
                 while(other_next_node != nullptr)
@@ -274,7 +718,7 @@ class SingleLinkedList
                     prev_node->next_node = new_node;
 
                     prev_node = new_node;
-                    other_next_node = other_next_node->next_node;
+                    other_next_node = Node::SkipErased(other_next_node->next_node);
                 }
 
                 tmp.size_ = other.size_;
@@ -286,6 +730,23 @@ class SingleLinkedList
             }
         }
 
+        // Перемещающий конструктор забирает цепочку узлов за время O(1)
+        SingleLinkedList(SingleLinkedList&& other) noexcept
+        {
+            swap(other);
+        }
+
+        SingleLinkedList& operator=(SingleLinkedList&& rhs) noexcept
+        {
+            if(this != &rhs)
+            {
+                SingleLinkedList tmp(std::move(rhs));
+                swap(tmp);
+            }
+
+            return *this;
+        }
+
         SingleLinkedList& operator=(const SingleLinkedList& rhs)
         {
             if(this == &rhs)
@@ -301,78 +762,1345 @@ class SingleLinkedList
         }
 
         // Обменивает содержимое списков за время O(1)
+        // Курсоры следуют за своими элементами, поэтому время обмена пропорционально числу курсоров
         void swap(SingleLinkedList& other) noexcept
         {
+            assert(transaction_ == nullptr && other.transaction_ == nullptr);
+
             std::swap(other.size_, size_);
+            std::swap(other.erased_count_, erased_count_);
             std::swap(other.head_.next_node, head_.next_node);
+            std::swap(other.cursors_, cursors_);
+            NotifyReset();
+            other.NotifyReset();
+
+            for(Cursor* cursor = cursors_; cursor != nullptr; cursor = cursor->next_cursor_)
+            {
+                cursor->list_ = this;
+            }
+
+            for(Cursor* cursor = other.cursors_; cursor != nullptr; cursor = cursor->next_cursor_)
+            {
+                cursor->list_ = &other;
+            }
         }
 
         ~SingleLinkedList()
         {
+            // Уничтожение списка — не изменение его содержимого, поэтому наблюдатель не уведомляется
+            observer_ = nullptr;
+
+            if(transaction_ != nullptr)
+            {
+                CommitTransaction();
+            }
+
             Clear();
-        }
 
-        // Возвращает количество элементов в списке за время O(1)
-        [[nodiscard]] size_t GetSize() const noexcept
-        {
-            return size_;
+            while(cursors_ != nullptr)
+            {
+                cursors_->Detach();
+            }
         }
 
-        // Сообщает, пустой ли список за время O(1)
-        [[nodiscard]] bool IsEmpty() const noexcept
+        // Вид позиционной правки
+        enum class EditType
         {
-            return size_ == 0 ? true : false;
-        }
+            Insert,
+            Erase
+        };
 
-        void PushFront(const Type& value)
+        // Позиционная правка для ApplyEdits
+        // Позиция отсчитывается в списке до применения пакета правок, в который входит правка
+        struct Edit
         {
-            head_.next_node = new Node(value, head_.next_node);
-            ++size_;
-        }
+            EditType type = EditType::Insert;
+            // Insert: номер элемента, перед которым вставляется value (размер списка — вставка в конец)
+            // Erase: номер удаляемого элемента
+            size_t index = 0;
+            // Вставляемое значение. Для Erase не используется
+            Type value{};
+        };
+
+        // Результат поиска одного ключа методом FindAll
+        struct FindResult
+        {
+            // Итератор на первый элемент, равный ключу, либо end(), если такого элемента нет
+            Iterator position;
+            // Итератор на элемент перед найденным — его можно передать в EraseAfter
+            Iterator before;
+        };
 
-        void PopFront() noexcept
+        /*
+         * Ищет в списке первые вхождения всех ключей keys за один проход
+         * out[i] получает результат поиска keys[i]. Ключи помещаются в хеш-таблицу (без копирования),
+         * поэтому поиск q ключей в списке из n элементов занимает O(n + q) вместо O(q·n)
+         * Обход прекращается, как только найдены все ключи
+         */
+        template <typename Hash = std::hash<Type>, typename KeyEqual = std::equal_to<Type>>
+        void FindAll(const std::vector<Type>& keys, std::vector<FindResult>& out, Hash hash = Hash{}, KeyEqual equal = KeyEqual{})
         {
-            if(head_.next_node != nullptr)
+            out.assign(keys.size(), FindResult{end(), end()});
+
+            // Номер первого запроса для каждого различного ключа
+            std::unordered_map<std::reference_wrapper<const Type>, size_t, Hash, KeyEqual> first_query(keys.size(), hash, equal);
+            // Номер первого запроса с тем же ключом, что и у i-го
+            std::vector<size_t> same_key_query(keys.size());
+
+            for(size_t i = 0; i < keys.size(); ++i)
             {
-                Node* node_for_del = head_.next_node;
-                Node* node_after_del = head_.next_node->next_node;
+                same_key_query[i] = first_query.emplace(std::cref(keys[i]), i).first->second;
+            }
 
-                if(node_after_del != nullptr)
-                {
-                    head_.next_node = node_after_del;
-                }
-                else
+            size_t unresolved_count = first_query.size();
+            Node* prev_node = &head_;
+
+            for(Node* node = Node::SkipErased(head_.next_node); node != nullptr && unresolved_count != 0; node = Node::SkipErased(node->next_node))
+            {
+                const auto query = first_query.find(std::cref(node->value));
+
+                if(query != first_query.end() && out[query->second].position == end())
                 {
-                    head_.next_node = nullptr;
+                    out[query->second] = FindResult{Iterator{node}, Iterator{prev_node}};
+                    --unresolved_count;
                 }
 
-                delete node_for_del;
+                prev_node = node;
             }
-        }
 
-        void Clear()
-        {
-            if(head_.next_node != nullptr)
+            for(size_t i = 0; i < keys.size(); ++i)
             {
-                Node* first_node = head_.next_node;
-
-                while(first_node != nullptr)
+                if(same_key_query[i] != i)
                 {
-                    Node* current_node = first_node;
-                    first_node = first_node->next_node;
-                    delete current_node;
-                    size_--;
+                    out[i] = out[same_key_query[i]];
                 }
             }
+        }
 
-            head_.next_node = nullptr;
-            size_ = 0;
+        // Подключает наблюдателя за изменениями списка (nullptr — отключает)
+        // Наблюдатель остаётся у объекта списка при обмене содержимым и не должен пережить список
+        void SetObserver(SingleLinkedListObserver<Type>* observer) noexcept
+        {
+            observer_ = observer;
+        }
+
+        [[nodiscard]] SingleLinkedListObserver<Type>* GetObserver() const noexcept
+        {
+            return observer_;
+        }
+
+        // Возвращает курсор на элемент, на который указывает pos (или на конец списка)
+        [[nodiscard]] Cursor MakeCursor(ConstIterator pos) noexcept
+        {
+            assert(pos.node_ != &head_);
+
+            return Cursor{this, pos.node_};
+        }
+
+        // Возвращает количество элементов в списке за время O(1)
+        [[nodiscard]] size_t GetSize() const noexcept
+        {
+            return size_;
+        }
+
+        // Сообщает, пустой ли список за время O(1)
+        [[nodiscard]] bool IsEmpty() const noexcept
+        {
+            return size_ == 0 ? true : false;
+        }
+
+        void PushFront(const Type& value)
+        {
+            InsertNodeAfter(&head_, value);
+        }
+
+        void PushFront(Type&& value)
+        {
+            InsertNodeAfter(&head_, std::move(value));
+        }
+
+        void PopFront() noexcept
+        {
+            if(size_ != 0)
+            {
+                EraseAfter(cbefore_begin());
+            }
+        }
+
+        // Удаляет все элементы списка. Курсоры переводятся в конец списка
+        void Clear()
+        {
+            if(observer_ != nullptr && head_.next_node != nullptr)
+            {
+                observer_->OnClear();
+            }
+
+            for(Cursor* cursor = cursors_; cursor != nullptr; cursor = cursor->next_cursor_)
+            {
+                cursor->node_ = nullptr;
+            }
+
+            if(transaction_ != nullptr)
+            {
+                // Вся цепочка освобождается при подтверждении транзакции одной записью
+                if(head_.next_node != nullptr)
+                {
+                    transaction_->removed_chains.push_back(head_.next_node);
+                    SetNext(&head_, nullptr);
+                }
+            }
+            else
+            {
+                DestroyChain(head_.next_node);
+            }
+
+            head_.next_node = nullptr;
+            size_ = 0;
+            erased_count_ = 0;
+        }
+
+        /*
+         * Логически удаляет элемент, на который указывает pos, за время O(1) без поиска предыдущего элемента
+         * Узел остаётся в цепочке: итераторы, указывающие на него, остаются действительными,
+         * а при обходе он пропускается. Память освобождается методом Compact()
+         */
+        void MarkErased(ConstIterator pos) noexcept
+        {
+            assert(pos.node_ != nullptr && pos.node_ != &head_);
+            assert(!pos.node_->IsErased());
+
+            if(transaction_ != nullptr)
+            {
+                assert(transaction_->erased_flags.size() < transaction_->erased_flags.capacity());
+                transaction_->erased_flags.push_back(pos.node_);
+            }
+
+            pos.node_->SetErased(true);
+            --size_;
+            ++erased_count_;
+            NotifyErase(pos.node_);
+        }
+
+        // Возвращает количество логически удалённых, но ещё не освобождённых элементов
+        [[nodiscard]] size_t GetErasedCount() const noexcept
+        {
+            return erased_count_;
+        }
+
+        /*
+         * Если логически удалённых элементов не меньше threshold, за один проход исключает их из цепочки
+         * и освобождает. Возвращает количество освобождённых узлов
+         * Итераторы, указывающие на освобождённые узлы, становятся недействительными
+         */
+        size_t Compact(size_t threshold = 0) noexcept
+        {
+            if(erased_count_ == 0 || erased_count_ < threshold)
+            {
+                return 0;
+            }
+
+            const size_t freed_count = erased_count_;
+            Node* prev_node = &head_;
+
+            while(erased_count_ != 0)
+            {
+                Node* node = prev_node->next_node;
+
+                if(node->IsErased())
+                {
+                    SetNext(prev_node, node->next_node);
+                    MoveCursors(node, Node::SkipErased(node->next_node));
+                    DestroyNode(node);
+                    --erased_count_;
+                }
+                else
+                {
+                    prev_node = node;
+                }
+            }
+
+            return freed_count;
+        }
+
+        /*
+         * Переносит в начало списка k наименьших (в смысле comp) элементов в порядке возрастания.
+         * Порядок остальных элементов (и логически удалённых узлов) не определён
+         * Если k больше размера списка, сортирует весь список
+         * Работает за O(n log k): узлы только перевязываются, значения не копируются,
+         * дополнительная память — два массива из k указателей
+         * Если comp выбросит исключение, список останется в прежнем состоянии
+         */
+        template <typename Compare = std::less<Type>>
+        void PartialSort(size_t k, Compare comp = Compare{})
+        {
+            k = std::min(k, size_);
+
+            if(k == 0)
+            {
+                return;
+            }
+
+            auto node_less = [&comp](const Node* lhs, const Node* rhs)
+            {
+                return comp(lhs->value, rhs->value);
+            };
+
+            // Max-куча из k узлов с наименьшими значениями, встреченных к текущему моменту
+            std::vector<Node*> heap;
+            heap.reserve(k);
+
+            for(Node* node = Node::SkipErased(head_.next_node); node != nullptr; node = Node::SkipErased(node->next_node))
+            {
+                if(heap.size() < k)
+                {
+                    heap.push_back(node);
+                    std::push_heap(heap.begin(), heap.end(), node_less);
+                }
+                else if(node_less(node, heap.front()))
+                {
+                    std::pop_heap(heap.begin(), heap.end(), node_less);
+                    heap.back() = node;
+                    std::push_heap(heap.begin(), heap.end(), node_less);
+                }
+            }
+
+            std::sort_heap(heap.begin(), heap.end(), node_less);
+
+            // Адреса выбранных узлов, упорядоченные для двоичного поиска при перевязке
+            std::vector<Node*> selected(heap);
+            std::sort(selected.begin(), selected.end(), std::less<Node*>{});
+            SaveAllLinks();
+
+            // Дальше исключений быть не может: остались только операции с указателями
+            Chain rest;
+
+            for(Node* node = head_.next_node; node != nullptr; )
+            {
+                Node* next_node = node->next_node;
+
+                if(!std::binary_search(selected.begin(), selected.end(), node, std::less<Node*>{}))
+                {
+                    rest.Append(node);
+                }
+
+                node = next_node;
+            }
+
+            Node* prev_node = &head_;
+
+            for(Node* node : heap)
+            {
+                prev_node->next_node = node;
+                prev_node = node;
+            }
+
+            prev_node->next_node = rest.head;
+
+            if(rest.tail != nullptr)
+            {
+                rest.tail->next_node = nullptr;
+            }
+
+            NotifyReset();
+        }
+
+        /*
+         * Переставляет элементы так, что на позиции k оказывается элемент, стоявший бы там после сортировки,
+         * перед ним — элементы не больше его, после него — не меньше (в смысле comp)
+         * Разбиение в духе quickselect выполняется перевязкой узлов на три цепочки (меньше, равно, больше),
+         * в среднем за O(n). Значения не копируются, дополнительная память не выделяется
+         * Логически удалённые узлы предварительно освобождаются (см. Compact)
+         * Если comp выбросит исключение, список сохранит все элементы, но их порядок не определён
+         */
+        template <typename Compare = std::less<Type>>
+        void NthElement(size_t k, Compare comp = Compare{})
+        {
+            assert(k < size_);
+
+            Compact();
+            SaveAllLinks();
+            NotifyReset();
+
+            // Текущий отрезок — length узлов, следующих за before
+            Node* before = &head_;
+            size_t length = size_;
+
+            while(length > 1)
+            {
+                // Опорным берём средний узел отрезка — это не ухудшает асимптотику прохода
+                // и защищает от квадратичного времени на уже упорядоченных данных
+                Node* pivot = before->next_node;
+
+                for(size_t i = 0; i < length / 2; ++i)
+                {
+                    pivot = pivot->next_node;
+                }
+
+                const Type& pivot_value = pivot->value;
+
+                Chain less;
+                Chain equal;
+                Chain greater;
+                size_t less_count = 0;
+                size_t equal_count = 0;
+                Node* node = before->next_node;
+
+                try
+                {
+                    for(size_t i = 0; i < length; ++i)
+                    {
+                        Node* next_node = node->next_node;
+
+                        if(comp(node->value, pivot_value))
+                        {
+                            less.Append(node);
+                            ++less_count;
+                        }
+                        else if(comp(pivot_value, node->value))
+                        {
+                            greater.Append(node);
+                        }
+                        else
+                        {
+                            equal.Append(node);
+                            ++equal_count;
+                        }
+
+                        node = next_node;
+                    }
+                }
+                catch(...)
+                {
+                    // Необработанный остаток отрезка начинается с node
+                    LinkChains(before, less, equal, greater, node);
+                    throw;
+                }
+
+                LinkChains(before, less, equal, greater, node);
+
+                if(k < less_count)
+                {
+                    length = less_count;
+                }
+                else if(k < less_count + equal_count)
+                {
+                    return;
+                }
+                else
+                {
+                    k -= less_count + equal_count;
+                    length -= less_count + equal_count;
+                    before = equal.tail;
+                }
+            }
+        }
+
+        /*
+         * Удаляет из неупорядоченного списка повторные вхождения элементов, сохраняя первые вхождения
+         * и их взаимный порядок. Возвращает количество удалённых элементов
+         * Работает за один проход с хеш-таблицей с открытой адресацией из указателей на значения:
+         * значения не копируются, а исключённые из цепочки узлы освобождаются одним пакетом в конце
+         * Если hash или equal выбросят исключение, список останется корректным, но удаление
+         * дубликатов будет выполнено лишь частично
+         */
+        template <typename Hash = std::hash<Type>, typename KeyEqual = std::equal_to<Type>>
+        size_t DedupStable(Hash hash = Hash{}, KeyEqual equal = KeyEqual{})
+        {
+            // Заполненность таблицы не превышает 1/2, поэтому цепочки проб остаются короткими
+            size_t capacity = 8;
+
+            while(capacity < size_ * 2)
+            {
+                capacity *= 2;
+            }
+
+            std::vector<const Type*> table(capacity, nullptr);
+            const size_t mask = capacity - 1;
+
+            SaveAllLinks();
+
+            Chain removed;
+            size_t removed_count = 0;
+            Node* prev_node = &head_;
+
+            try
+            {
+                while(prev_node->next_node != nullptr)
+                {
+                    Node* node = prev_node->next_node;
+
+                    if(node->IsErased())
+                    {
+                        prev_node = node;
+                        continue;
+                    }
+
+                    size_t slot = hash(node->value) & mask;
+                    bool duplicate = false;
+
+                    while(table[slot] != nullptr)
+                    {
+                        if(equal(*table[slot], node->value))
+                        {
+                            duplicate = true;
+                            break;
+                        }
+
+                        slot = (slot + 1) & mask;
+                    }
+
+                    if(duplicate)
+                    {
+                        prev_node->next_node = node->next_node;
+                        MoveCursors(node, Node::SkipErased(node->next_node));
+                        NotifyErase(node);
+                        removed.Append(node);
+                        ++removed_count;
+                        --size_;
+                    }
+                    else
+                    {
+                        table[slot] = &node->value;
+                        prev_node = node;
+                    }
+                }
+            }
+            catch(...)
+            {
+                ReleaseChain(removed);
+                throw;
+            }
+
+            ReleaseChain(removed);
+
+            return removed_count;
+        }
+
+        /*
+         * Применяет пакет позиционных правок за один проход по списку
+         * Позиции всех правок относятся к состоянию списка до применения пакета; поправки на сдвиг,
+         * вызванный предыдущими правками, учитываются при проходе. Вставки в одну позицию выполняются
+         * в порядке их следования в пакете и раньше удаления элемента, стоящего в этой позиции
+         * Правки упорядочиваются по позиции за O(e log e), затем применяются за O(n + e)
+         * Все новые узлы создаются до изменения списка, поэтому при исключении список останется
+         * в прежнем состоянии
+         */
+        void ApplyEdits(const std::vector<Edit>& edits)
+        {
+            std::vector<const Edit*> order;
+            order.reserve(edits.size());
+
+            for(const Edit& edit : edits)
+            {
+                assert(edit.type == EditType::Insert ? edit.index <= size_ : edit.index < size_);
+                order.push_back(&edit);
+            }
+
+            std::stable_sort(order.begin(), order.end(), [](const Edit* lhs, const Edit* rhs)
+            {
+                return lhs->index != rhs->index ? lhs->index < rhs->index
+                                                : lhs->type == EditType::Insert && rhs->type == EditType::Erase;
+            });
+
+            // Один и тот же элемент нельзя удалить дважды
+            assert(std::adjacent_find(order.begin(), order.end(), [](const Edit* lhs, const Edit* rhs)
+            {
+                return lhs->type == EditType::Erase && rhs->type == EditType::Erase && lhs->index == rhs->index;
+            }) == order.end());
+
+            const size_t insert_count = static_cast<size_t>(std::count_if(order.begin(), order.end(), [](const Edit* edit)
+            {
+                return edit->type == EditType::Insert;
+            }));
+            ReserveUndo(order.size(), insert_count, order.size() - insert_count);
+
+            Chain inserted;
+
+            try
+            {
+                for(const Edit* edit : order)
+                {
+                    if(edit->type == EditType::Insert)
+                    {
+                        inserted.Append(new Node(edit->value, nullptr));
+                    }
+                }
+            }
+            catch(...)
+            {
+                DeleteChain(inserted);
+                throw;
+            }
+
+            // prev_node — узел, за которым находится текущая позиция, position — число пройденных исходных элементов
+            Node* prev_node = &head_;
+            size_t position = 0;
+            Node* new_node = inserted.head;
+
+            for(const Edit* edit : order)
+            {
+                for(; position < edit->index; ++position)
+                {
+                    prev_node = Node::SkipErased(prev_node->next_node);
+                }
+
+                if(edit->type == EditType::Insert)
+                {
+                    Node* next_new_node = new_node->next_node;
+                    new_node->next_node = prev_node->next_node;
+                    RecordInserted(new_node);
+                    SetNext(prev_node, new_node);
+                    NotifyInsert(prev_node, new_node);
+                    prev_node = new_node;
+                    new_node = next_new_node;
+                    ++size_;
+                }
+                else
+                {
+                    while(prev_node->next_node->IsErased())
+                    {
+                        prev_node = prev_node->next_node;
+                    }
+
+                    Node* node_for_del = prev_node->next_node;
+                    SetNext(prev_node, node_for_del->next_node);
+                    MoveCursors(node_for_del, Node::SkipErased(node_for_del->next_node));
+                    NotifyErase(node_for_del);
+                    DestroyNode(node_for_del);
+                    --size_;
+                    ++position;
+                }
+            }
+        }
+
+        /*
+         * Заменяет каждый элемент результатом op над всеми элементами от первого до него включительно
+         * op должна быть ассоциативной. Список делится на отрезки по числу потоков executor,
+         * которые обрабатываются параллельно в два прохода: свёртка каждого отрезка, последовательное
+         * вычисление переносов между отрезками и досчёт каждого отрезка с его переносом
+         * Поиск границ отрезков — последовательный проход по цепочке без вызовов op
+         * Наблюдатель получает OnReset(). Если op выбросит исключение, часть элементов может быть уже изменена
+         */
+        template <typename BinaryOp = std::plus<Type>>
+        void InclusiveScanInPlace(BinaryOp op = BinaryOp{}, ListExecutor& executor = DefaultListExecutor())
+        {
+            ScanInPlace<true>(nullptr, op, executor);
+        }
+
+        // Заменяет каждый элемент результатом op над init и всеми предшествующими ему элементами
+        // Работает так же, как InclusiveScanInPlace
+        template <typename BinaryOp = std::plus<Type>>
+        void ExclusiveScanInPlace(Type init, BinaryOp op = BinaryOp{}, ListExecutor& executor = DefaultListExecutor())
+        {
+            ScanInPlace<false>(&init, op, executor);
+        }
+
+        /*
+         * Вызывает function для каждого элемента; отрезки списка обрабатываются параллельно на executor
+         * Порядок вызовов не определён. Если function выбросит исключение, часть вызовов может не состояться
+         * Элементы передаются по константной ссылке; для изменения элементов служит ForEachInPlace
+         */
+        template <typename Function>
+        void ForEach(Function function, ListExecutor& executor = DefaultListExecutor()) const
+        {
+            VisitSegments<const Type>(function, executor);
+        }
+
+        /*
+         * Работает так же, как ForEach, но передаёт function изменяемые ссылки на элементы
+         * Наблюдатель получает OnReset(), в том числе если function выбросит исключение
+         */
+        template <typename Function>
+        void ForEachInPlace(Function function, ListExecutor& executor = DefaultListExecutor())
+        {
+            try
+            {
+                VisitSegments<Type>(function, executor);
+            }
+            catch(...)
+            {
+                NotifyReset();
+                throw;
+            }
+
+            NotifyReset();
+        }
+
+        /*
+         * Возвращает результат op над init и всеми элементами; отрезки сворачиваются параллельно на executor
+         * op должна быть ассоциативной; порядок элементов сохраняется, поэтому коммутативность не нужна
+         */
+        template <typename BinaryOp = std::plus<Type>>
+        [[nodiscard]] Type Reduce(Type init, BinaryOp op = BinaryOp{}, ListExecutor& executor = DefaultListExecutor()) const
+        {
+            const std::vector<Node*> starts = SplitSegments(executor);
+            std::vector<std::optional<Type>> sums(starts.size() - 1);
+
+            ParallelFor(executor, sums.size(), [&](size_t j)
+            {
+                sums[j] = ReduceSegment(starts[j], starts[j + 1], op);
+            });
+
+            for(std::optional<Type>& sum : sums)
+            {
+                init = op(init, *sum);
+            }
+
+            return init;
+        }
+
+        /*
+         * Начинает транзакцию. До её завершения список ведёт журнал отмены: каждое изменение связи
+         * между узлами записывается, а удалённые узлы не освобождаются до CommitTransaction()
+         * Поэтому Rollback() восстанавливает в точности прежнюю цепочку за время, пропорциональное
+         * числу изменений, без копирования списка. Вложенные транзакции не поддерживаются
+         * Курсоры, переведённые на другие элементы при удалениях, при откате остаются на новых местах
+         * Журнал отмены сразу резервируется с запасом на удаление каждого узла (около 32 байт на узел),
+         * поэтому удаления в транзакции, как и вне её, не выбрасывают исключений
+         */
+        void BeginTransaction()
+        {
+            assert(transaction_ == nullptr);
+
+            transaction_ = std::make_unique<Transaction>();
+            transaction_->size = size_;
+            transaction_->erased_count = erased_count_;
+
+            try
+            {
+                ReserveUndo(0, 0);
+            }
+            catch(...)
+            {
+                transaction_.reset();
+                throw;
+            }
+
+            if(observer_ != nullptr)
+            {
+                observer_->OnTransactionBegin();
+            }
+        }
+
+        [[nodiscard]] bool IsInTransaction() const noexcept
+        {
+            return transaction_ != nullptr;
+        }
+
+        // Подтверждает изменения транзакции и освобождает удалённые в ней узлы
+        void CommitTransaction() noexcept
+        {
+            assert(transaction_ != nullptr);
+
+            std::unique_ptr<Transaction> transaction = std::move(transaction_);
+
+            Node::DestroyBatch(transaction->removed.data(), transaction->removed.size());
+
+            for(Node* chain : transaction->removed_chains)
+            {
+                DestroyChain(chain);
+            }
+
+            if(observer_ != nullptr)
+            {
+                observer_->OnTransactionCommit();
+            }
+        }
+
+        // Отменяет изменения транзакции: восстанавливает связи узлов и освобождает вставленные в ней узлы
+        void Rollback() noexcept
+        {
+            assert(transaction_ != nullptr);
+
+            std::unique_ptr<Transaction> transaction = std::move(transaction_);
+
+            for(auto it = transaction->links.rbegin(); it != transaction->links.rend(); ++it)
+            {
+                it->first->next_node = it->second;
+            }
+
+            for(Node* node : transaction->erased_flags)
+            {
+                node->SetErased(false);
+            }
+
+            if(cursors_ != nullptr && !transaction->inserted.empty())
+            {
+                // Курсоры со вставленных узлов переводятся на первый сохраняемый узел после них
+                std::unordered_set<const Node*> inserted(transaction->inserted.begin(), transaction->inserted.end());
+
+                for(Cursor* cursor = cursors_; cursor != nullptr; cursor = cursor->next_cursor_)
+                {
+                    while(inserted.count(cursor->node_) != 0)
+                    {
+                        cursor->node_ = cursor->node_->next_node;
+                    }
+
+                    cursor->node_ = Node::SkipErased(cursor->node_);
+                }
+            }
+
+            Node::DestroyBatch(transaction->inserted.data(), transaction->inserted.size());
+
+            size_ = transaction->size;
+            erased_count_ = transaction->erased_count;
+
+            if(observer_ != nullptr)
+            {
+                observer_->OnTransactionRollback();
+            }
+
+            NotifyReset();
+        }
+
+        /*
+         * Ищет keys[i] в списке *lists[i] для всех i и записывает в out[i] итератор на первый равный элемент
+         * либо end() соответствующего списка
+         * Обходы выполняются как конечные автоматы группами по group_size (AMAC): для каждого обхода
+         * запрашивается предвыборка следующего узла, и, пока он загружается из памяти, продвигаются
+         * остальные обходы группы. Так задержки промахов кеша независимых списков перекрываются,
+         * а не складываются
+         */
+        template <typename KeyEqual = std::equal_to<Type>>
+        static void FindInterleaved(const std::vector<const SingleLinkedList*>& lists, const std::vector<Type>& keys,
+                                    std::vector<ConstIterator>& out, KeyEqual equal = KeyEqual{}, size_t group_size = 16)
+        {
+            assert(lists.size() == keys.size() && group_size > 0);
+
+            // Незавершённый обход: номер запроса и узел, который будет проверен следующим
+            struct Probe
+            {
+                size_t index;
+                const Node* node;
+            };
+
+            out.assign(keys.size(), ConstIterator{nullptr});
+
+            size_t next_index = 0;
+
+            // Начинает в probe следующий запрос с непустым списком. Возвращает false, если запросов не осталось
+            const auto start_probe = [&](Probe& probe) noexcept
+            {
+                while(next_index < keys.size())
+                {
+                    probe.index = next_index++;
+                    probe.node = lists[probe.index]->head_.next_node;
+
+                    if(probe.node != nullptr)
+                    {
+                        Prefetch(probe.node);
+                        return true;
+                    }
+                }
+
+                return false;
+            };
+
+            std::vector<Probe> group;
+            group.reserve(std::min(group_size, keys.size()));
+
+            for(Probe probe{}; group.size() < group_size && start_probe(probe); )
+            {
+                group.push_back(probe);
+            }
+
+            while(!group.empty())
+            {
+                for(size_t slot = 0; slot < group.size(); )
+                {
+                    Probe& probe = group[slot];
+                    const Node* node = probe.node;
+
+                    if(!node->IsErased() && equal(node->value, keys[probe.index]))
+                    {
+                        out[probe.index] = ConstIterator{const_cast<Node*>(node)};
+                    }
+                    else if(node->next_node != nullptr)
+                    {
+                        probe.node = node->next_node;
+                        Prefetch(probe.node);
+                        ++slot;
+                        continue;
+                    }
+
+                    // Обход завершён: его место занимает следующий запрос либо последний обход группы
+                    if(start_probe(probe))
+                    {
+                        ++slot;
+                    }
+                    else
+                    {
+                        probe = group.back();
+                        group.pop_back();
+                    }
+                }
+            }
+        }
+
+        /*
+         * Превращает список в неизменяемый FrozenList: значения перемещаются в один непрерывный блок памяти
+         * в порядке следования, а список становится пустым
+         * Логически удалённые элементы в FrozenList не попадают
+         */
+        [[nodiscard]] FrozenList<Type> Freeze()
+        {
+            assert(transaction_ == nullptr);
+
+            std::vector<Type> values;
+            values.reserve(size_);
+
+            for(Type& value : *this)
+            {
+                values.push_back(std::move(value));
+            }
+
+            Clear();
+
+            return FrozenList<Type>(std::move(values));
+        }
+
+    private:
+        // Журнал отмены активной транзакции
+        struct Transaction
+        {
+            // Узел и прежнее значение его указателя next_node
+            std::vector<std::pair<Node*, Node*>> links;
+            // Узлы, логически удалённые в транзакции
+            std::vector<Node*> erased_flags;
+            // Узлы, созданные в транзакции; освобождаются при откате
+            std::vector<Node*> inserted;
+            // Узлы, исключённые из списка в транзакции; освобождаются при подтверждении
+            std::vector<Node*> removed;
+            // Цепочки узлов, завершающиеся nullptr, исключённые из списка методом Clear()
+            std::vector<Node*> removed_chains;
+            size_t size = 0;
+            size_t erased_count = 0;
+        };
+
+        // Цепочка узлов, собираемая при перевязке. Указатель next_node хвоста не поддерживается
+        struct Chain
+        {
+            void Append(Node* node) noexcept
+            {
+                if(head == nullptr)
+                {
+                    head = node;
+                }
+                else
+                {
+                    tail->next_node = node;
+                }
+
+                tail = node;
+            }
+
+            Node* head = nullptr;
+            Node* tail = nullptr;
+        };
+
+        // Запрашивает предвыборку строки кеша с указанным адресом
+        static void Prefetch(const void* address) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(address);
+#else
+            (void)address;
+#endif
+        }
+
+        // Создаёт узел со значением value и вставляет его после pos
+        // Если при создании узла будет выброшено исключение, список останется в прежнем состоянии
+        template <typename Value>
+        Iterator InsertNodeAfter(Node* pos, Value&& value)
+        {
+            assert(pos != nullptr);
+
+            ReserveUndo(1, 1);
+            Node* new_node = new Node(std::forward<Value>(value), pos->next_node);
+            RecordInserted(new_node);
+            SetNext(pos, new_node);
+            ++size_;
+            NotifyInsert(pos, new_node);
+
+            return Iterator{new_node};
+        }
+
+        // Изменяет связь узла, записывая прежнюю связь в журнал отмены активной транзакции
+        // Место в журнале зарезервировано заранее (см. ReserveUndo)
+        void SetNext(Node* node, Node* next_node) noexcept
+        {
+            if(transaction_ != nullptr)
+            {
+                assert(transaction_->links.size() < transaction_->links.capacity());
+                transaction_->links.emplace_back(node, node->next_node);
+            }
+
+            node->next_node = next_node;
+        }
+
+        /*
+         * Заранее резервирует место в журнале отмены, чтобы последующие записи не выбрасывали исключений
+         * Сверх записей самой операции всегда остаётся запас на удаление каждого узла, который будет
+         * в списке после неё: EraseAfter, MarkErased и Compact пишут в журнал без резервирования
+         * и потому остаются noexcept. Удаление узла расходует запас на один узел, поэтому он сохраняется
+         * Вызывается операциями, которые и так могут выбросить исключение, до первого изменения списка
+         */
+        void ReserveUndo(size_t link_count, size_t inserted_count, size_t removed_count = 0)
+        {
+            if(transaction_ != nullptr)
+            {
+                const size_t node_count = size_ + erased_count_ + inserted_count;
+
+                ReserveMore(transaction_->links, link_count + node_count);
+                ReserveMore(transaction_->inserted, inserted_count);
+                ReserveMore(transaction_->removed, removed_count + node_count);
+                ReserveMore(transaction_->erased_flags, size_ + inserted_count);
+            }
+        }
+
+        // Резервирует место ещё под count записей. Ёмкость растёт геометрически, чтобы резервирование
+        // перед каждой операцией в цикле не приводило к перевыделению на каждой итерации
+        template <typename Vector>
+        static void ReserveMore(Vector& log, size_t count)
+        {
+            if(log.capacity() - log.size() < count)
+            {
+                log.reserve(std::max(log.size() + count, 2 * log.capacity()));
+            }
+        }
+
+        void RecordInserted(Node* node) noexcept
+        {
+            if(transaction_ != nullptr)
+            {
+                transaction_->inserted.push_back(node);
+            }
+        }
+
+        // Освобождает узел, исключённый из списка, либо откладывает освобождение до конца транзакции
+        void DestroyNode(Node* node) noexcept
+        {
+            if(transaction_ != nullptr)
+            {
+                assert(transaction_->removed.size() < transaction_->removed.capacity());
+                transaction_->removed.push_back(node);
+            }
+            else
+            {
+                delete node;
+            }
+        }
+
+        // Сохраняет в журнал отмены связи всех узлов перед перевязкой всего списка
+        void SaveAllLinks()
+        {
+            if(transaction_ == nullptr)
+            {
+                return;
+            }
+
+            ReserveUndo(size_ + erased_count_ + 1, 0);
+
+            for(Node* node = &head_; node != nullptr; node = node->next_node)
+            {
+                transaction_->links.emplace_back(node, node->next_node);
+            }
+        }
+
+        // Освобождает узлы цепочки, исключённые из списка, с учётом активной транзакции
+        void ReleaseChain(const Chain& chain)
+        {
+            if(chain.head == nullptr)
+            {
+                return;
+            }
+
+            if(transaction_ != nullptr)
+            {
+                chain.tail->next_node = nullptr;
+                transaction_->removed_chains.push_back(chain.head);
+            }
+            else
+            {
+                DeleteChain(chain);
+            }
+        }
+
+        // Освобождает узлы цепочки, уже исключённые из списка
+        static void DeleteChain(const Chain& chain) noexcept
+        {
+            if(chain.head == nullptr)
+            {
+                return;
+            }
+
+            chain.tail->next_node = nullptr;
+            DestroyChain(chain.head);
+        }
+
+        /*
+         * Освобождает цепочку узлов, завершающуюся nullptr
+         * Обход цепочки упирается в промахи кеша: адрес следующего узла известен, только когда загружен текущий
+         * Поэтому указатель ahead идёт на kPrefetchDistance узлов впереди и запрашивает их предвыборку,
+         * а деструкторы значений выполняются, пока загружаются следующие узлы. Память узлов
+         * возвращается распределителю пакетами за один захват его блокировки
+         * Сначала пройти пакет, а потом вызвать деструкторы, медленнее: проход пакета — одни
+         * последовательные промахи, которым нечем перекрыться
+         */
+        static void DestroyChain(Node* node) noexcept
+        {
+            constexpr size_t kBatchSize = 64;
+            constexpr size_t kPrefetchDistance = 16;
+
+            Node* batch[kBatchSize];
+            size_t count = 0;
+            Node* ahead = node;
+
+            for(size_t i = 0; i < kPrefetchDistance && ahead != nullptr; ++i)
+            {
+                Prefetch(ahead);
+                ahead = ahead->next_node;
+            }
+
+            while(node != nullptr)
+            {
+                if(ahead != nullptr)
+                {
+                    Prefetch(ahead);
+                    ahead = ahead->next_node;
+                }
+
+                Node* next_node = node->next_node;
+                node->~Node();
+                batch[count++] = node;
+
+                if(count == kBatchSize)
+                {
+                    Node::DeallocateBatch(batch, count);
+                    count = 0;
+                }
+
+                node = next_node;
+            }
+
+            Node::DeallocateBatch(batch, count);
+        }
+
+        void NotifyInsert(const Node* pos, const Node* node) const noexcept
+        {
+            if(observer_ != nullptr)
+            {
+                observer_->OnInsert(pos == &head_ ? nullptr : &pos->value, &node->value, node->value);
+            }
+        }
+
+        void NotifyErase(const Node* node) const noexcept
+        {
+            if(observer_ != nullptr)
+            {
+                observer_->OnErase(&node->value);
+            }
+        }
+
+        void NotifyReset() const noexcept
+        {
+            if(observer_ != nullptr)
+            {
+                observer_->OnReset();
+            }
+        }
+
+        // Переводит курсоры, указывающие на удаляемый узел node, на узел successor
+        void MoveCursors(const Node* node, Node* successor) noexcept
+        {
+            for(Cursor* cursor = cursors_; cursor != nullptr; cursor = cursor->next_cursor_)
+            {
+                if(cursor->node_ == node)
+                {
+                    cursor->node_ = successor;
+                }
+            }
+        }
+
+        // Отрезок списка короче этого не выгодно обрабатывать в отдельном потоке
+        static constexpr size_t kMinParallelSegment = 1024;
+
+        /*
+         * Делит список на почти равные по числу элементов отрезки — не больше, чем потоков у executor
+         * Возвращает первые узлы отрезков и завершающий nullptr; для пустого списка — только nullptr
+         */
+        std::vector<Node*> SplitSegments(const ListExecutor& executor) const
+        {
+            const size_t segment_count = size_ == 0 ? 0 : std::max<size_t>(1, std::min(executor.GetConcurrency(), size_ / kMinParallelSegment));
+
+            std::vector<Node*> starts;
+            starts.reserve(segment_count + 1);
+            Node* node = Node::SkipErased(head_.next_node);
+
+            for(size_t j = 0; j < segment_count; ++j)
+            {
+                starts.push_back(node);
+
+                for(size_t i = size_ / segment_count + (j < size_ % segment_count ? 1 : 0); i != 0; --i)
+                {
+                    node = Node::SkipErased(node->next_node);
+                }
+            }
+
+            starts.push_back(nullptr);
+
+            return starts;
+        }
+
+        // Вызывает function для элементов отрезков параллельно, передавая их как ValueType&
+        template <typename ValueType, typename Function>
+        void VisitSegments(Function& function, ListExecutor& executor) const
+        {
+            const std::vector<Node*> starts = SplitSegments(executor);
+
+            ParallelFor(executor, starts.size() - 1, [&](size_t j)
+            {
+                for(Node* node = starts[j]; node != starts[j + 1]; node = Node::SkipErased(node->next_node))
+                {
+                    function(static_cast<ValueType&>(node->value));
+                }
+            });
+        }
+
+        // Значения меняются на месте, поэтому изменение передаётся наблюдателю целиком, в том числе
+        // при исключении из op
+        template <bool Inclusive, typename BinaryOp>
+        void ScanInPlace(const Type* init, BinaryOp& op, ListExecutor& executor)
+        {
+            try
+            {
+                ScanSegments<Inclusive>(init, op, executor);
+            }
+            catch(...)
+            {
+                NotifyReset();
+                throw;
+            }
+
+            NotifyReset();
+        }
+
+        template <bool Inclusive, typename BinaryOp>
+        void ScanSegments(const Type* init, BinaryOp& op, ListExecutor& executor)
+        {
+            const std::vector<Node*> starts = SplitSegments(executor);
+            const size_t segment_count = starts.size() - 1;
+
+            if(segment_count <= 1)
+            {
+                if(segment_count == 1)
+                {
+                    ScanSegment<Inclusive>(starts[0], nullptr, init, op);
+                }
+
+                return;
+            }
+
+            // Первый проход: свёртки всех отрезков, кроме последнего
+            std::vector<std::optional<Type>> sums(segment_count - 1);
+
+            ParallelFor(executor, sums.size(), [&](size_t j)
+            {
+                sums[j] = ReduceSegment(starts[j], starts[j + 1], op);
+            });
+
+            // Переносы: результат op над init и всеми элементами предыдущих отрезков
+            std::vector<std::optional<Type>> carries(segment_count);
+
+            if(init != nullptr)
+            {
+                carries[0] = *init;
+            }
+
+            for(size_t j = 1; j < segment_count; ++j)
+            {
+                carries[j] = carries[j - 1] ? op(*carries[j - 1], *sums[j - 1]) : std::move(*sums[j - 1]);
+            }
+
+            // Второй проход: каждый отрезок досчитывается со своим переносом
+            ParallelFor(executor, segment_count, [&](size_t j)
+            {
+                ScanSegment<Inclusive>(starts[j], starts[j + 1], carries[j] ? &*carries[j] : nullptr, op);
+            });
+        }
+
+        // Свёртка элементов от узла first до узла last, не включая его
+        template <typename BinaryOp>
+        static Type ReduceSegment(Node* first, Node* last, BinaryOp& op)
+        {
+            Type sum = first->value;
+
+            for(Node* node = Node::SkipErased(first->next_node); node != last; node = Node::SkipErased(node->next_node))
+            {
+                sum = op(sum, node->value);
+            }
+
+            return sum;
+        }
+
+        // Последовательный scan элементов от узла first до узла last, не включая его, с начальным значением carry
+        template <bool Inclusive, typename BinaryOp>
+        static void ScanSegment(Node* first, Node* last, const Type* carry, BinaryOp& op)
+        {
+            if constexpr(Inclusive)
+            {
+                if(carry != nullptr)
+                {
+                    first->value = op(*carry, first->value);
+                }
+
+                for(Node* prev_node = first, *node = Node::SkipErased(first->next_node); node != last;
+                    prev_node = node, node = Node::SkipErased(node->next_node))
+                {
+                    node->value = op(prev_node->value, node->value);
+                }
+            }
+            else
+            {
+                assert(carry != nullptr);
+
+                Type sum = *carry;
+
+                for(Node* node = first; node != last; node = Node::SkipErased(node->next_node))
+                {
+                    Type next_sum = op(sum, node->value);
+                    node->value = std::move(sum);
+                    sum = std::move(next_sum);
+                }
+            }
+        }
+
+        // Подвешивает за узлом before цепочки first, second, third (пустые пропускаются), а за ними — rest
+        static void LinkChains(Node* before, const Chain& first, const Chain& second, const Chain& third, Node* rest) noexcept
+        {
+            Node* prev_node = before;
+
+            for(const Chain* chain : {&first, &second, &third})
+            {
+                if(chain->head != nullptr)
+                {
+                    prev_node->next_node = chain->head;
+                    prev_node = chain->tail;
+                }
+            }
+
+            prev_node->next_node = rest;
         }
 
-    private:
         // Фиктивный узел, используется для вставки "перед первым элементом"
         Node head_;
         size_t size_ = 0;
+        // Количество логически удалённых узлов, ожидающих Compact()
+        size_t erased_count_ = 0;
+        // Первый курсор в реестре курсоров списка
+        Cursor* cursors_ = nullptr;
+        SingleLinkedListObserver<Type>* observer_ = nullptr;
+        std::unique_ptr<Transaction> transaction_;
 };
 
 template <typename Type>
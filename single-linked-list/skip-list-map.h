@@ -0,0 +1,553 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "epoch-reclamation.h"
+#include "node-arena.h"
+
+/*
+ * Параллельный упорядоченный словарь на списке с пропусками (skip list)
+ * Нижний уровень — односвязный список Харриса — Майкла со всеми элементами по возрастанию ключей,
+ * верхние уровни — ускоряющие ссылки через часть узлов; поиск занимает O(log n) в среднем
+ * Удаляемый узел помечается битом в своих указателях next сверху вниз; пометка нижнего уровня
+ * и есть удаление. Затем узел исключается со всех уровней, и через EpochReclamation освобождается
+ * последним из потоков — удаляющего и вставившего его, — так что узел не освобождается, пока
+ * вставляющий поток ещё может связать с ним верхний уровень
+ * Уровни списка меняются только через CAS и блокировок не берут
+ * Узлы с башнями разной высоты выделяются из распределителей NodeArena точного размера — обычно
+ * из кеша потока без блокировок; когда кеш пуст или полон, распределитель ненадолго берёт свою
+ * блокировку. Поэтому вставка и удаление (а через EpochReclamation и освобождение узлов, которое
+ * выполняет удаляющий или вставивший поток) не свободны от блокировок в строгом смысле, как и при malloc
+ * Все методы можно вызывать из любых потоков одновременно, кроме конструктора и деструктора
+ * Значения не меняются после вставки
+ */
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class SkipListMap
+{
+    using Link = std::atomic<std::uintptr_t>;
+
+    // Узел с башней из height ссылок, расположенной в памяти сразу за ним
+    struct Node
+    {
+        Node(Key key, Value value, size_t tower_height) : entry(std::move(key), std::move(value)), height(tower_height)
+        {
+        }
+
+        Link* Tower() noexcept
+        {
+            return reinterpret_cast<Link*>(reinterpret_cast<char*>(this) + kTowerOffset);
+        }
+
+        const std::pair<const Key, Value> entry;
+        const size_t height;
+        // Кто из вставляющего и удаляющего потоков уже закончил работу с узлом
+        std::atomic<unsigned> done{0};
+    };
+
+    public:
+        using value_type = std::pair<const Key, Value>;
+
+        /*
+         * Итератор по элементам в порядке возрастания ключей; пропускает удалённые элементы
+         * Действителен, только пока поток находится внутри EpochReclamation::Guard, в котором итератор получен
+         * При одновременных изменениях обход видит каждый элемент, который был в словаре всё время обхода
+         */
+        class ConstIterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = SkipListMap::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const value_type*;
+                using reference = const value_type&;
+
+                ConstIterator() = default;
+
+                [[nodiscard]] bool operator==(const ConstIterator& rhs) const noexcept
+                {
+                    return node_ == rhs.node_;
+                }
+
+                [[nodiscard]] bool operator!=(const ConstIterator& rhs) const noexcept
+                {
+                    return !(*this == rhs);
+                }
+
+                ConstIterator& operator++() noexcept
+                {
+                    assert(node_ != nullptr);
+
+                    node_ = SkipMarked(Pointer(node_->Tower()[0].load(std::memory_order_acquire)));
+
+                    return *this;
+                }
+
+                ConstIterator operator++(int) noexcept
+                {
+                    auto old_value(*this);
+                    ++(*this);
+                    return old_value;
+                }
+
+                [[nodiscard]] reference operator*() const noexcept
+                {
+                    return node_->entry;
+                }
+
+                [[nodiscard]] pointer operator->() const noexcept
+                {
+                    return &node_->entry;
+                }
+
+            private:
+                friend class SkipListMap;
+
+                explicit ConstIterator(Node* node) noexcept : node_(node)
+                {
+                }
+
+                Node* node_ = nullptr;
+        };
+
+        explicit SkipListMap(Compare compare = Compare()) : compare_(std::move(compare))
+        {
+        }
+
+        SkipListMap(const SkipListMap&) = delete;
+        SkipListMap& operator=(const SkipListMap&) = delete;
+
+        // Вызывается, когда словарь больше не используют другие потоки
+        ~SkipListMap()
+        {
+            Node* node = Pointer(head_[0].load(std::memory_order_relaxed));
+
+            while(node != nullptr)
+            {
+                Node* next = Pointer(node->Tower()[0].load(std::memory_order_relaxed));
+                Destroy(node);
+                node = next;
+            }
+        }
+
+        // Вставляет элемент, если элемента с таким ключом нет. Возвращает true, если вставил
+        bool Insert(Key key, Value value)
+        {
+            EpochReclamation::Guard guard;
+            const size_t height = RandomHeight();
+            Node* node = Create(std::move(key), std::move(value), height);
+            const Key& node_key = node->entry.first;
+            Link* preds[kMaxHeight];
+            Node* succs[kMaxHeight];
+
+            // Узел появляется в словаре, когда связан нижний уровень
+            while(true)
+            {
+                if(Find(node_key, preds, succs))
+                {
+                    Destroy(node);
+
+                    return false;
+                }
+
+                for(size_t level = 0; level < height; ++level)
+                {
+                    node->Tower()[level].store(reinterpret_cast<std::uintptr_t>(succs[level]), std::memory_order_relaxed);
+                }
+
+                std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(succs[0]);
+
+                if(preds[0][0].compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node),
+                                                       std::memory_order_release, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+
+            size_.fetch_add(1, std::memory_order_relaxed);
+            LinkUpperLevels(node, preds, succs);
+
+            return true;
+        }
+
+        // Удаляет элемент с ключом key. Возвращает true, если удалил
+        bool Erase(const Key& key)
+        {
+            EpochReclamation::Guard guard;
+            Link* preds[kMaxHeight];
+            Node* succs[kMaxHeight];
+
+            if(!Find(key, preds, succs))
+            {
+                return false;
+            }
+
+            Node* node = succs[0];
+
+            for(size_t level = node->height; level-- > 1; )
+            {
+                node->Tower()[level].fetch_or(kMark, std::memory_order_acq_rel);
+            }
+
+            // Удаляет тот поток, который пометил нижний уровень
+            if((node->Tower()[0].fetch_or(kMark) & kMark) != 0)
+            {
+                return false;
+            }
+
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            Finish(node);
+
+            return true;
+        }
+
+        // Возвращает копию значения элемента с ключом key либо std::nullopt
+        [[nodiscard]] std::optional<Value> Find(const Key& key) const
+        {
+            EpochReclamation::Guard guard;
+            Node* node = LowerBoundNode(key);
+
+            if(node == nullptr || compare_(key, node->entry.first))
+            {
+                return std::nullopt;
+            }
+
+            return node->entry.second;
+        }
+
+        [[nodiscard]] bool Contains(const Key& key) const
+        {
+            return Find(key).has_value();
+        }
+
+        // Число элементов; при одновременных изменениях — приблизительное
+        [[nodiscard]] size_t GetSize() const noexcept
+        {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        // Итераторы действительны только внутри EpochReclamation::Guard
+        [[nodiscard]] ConstIterator begin() const noexcept
+        {
+            return ConstIterator{SkipMarked(Pointer(head_[0].load(std::memory_order_acquire)))};
+        }
+
+        [[nodiscard]] ConstIterator end() const noexcept
+        {
+            return {};
+        }
+
+        // Первый элемент с ключом не меньше key. Итератор действителен только внутри EpochReclamation::Guard
+        [[nodiscard]] ConstIterator LowerBound(const Key& key) const
+        {
+            return ConstIterator{LowerBoundNode(key)};
+        }
+
+        // Вызывает function для элементов с ключами из [from, to) по возрастанию ключей
+        template <typename Function>
+        void ForEachInRange(const Key& from, const Key& to, Function function) const
+        {
+            EpochReclamation::Guard guard;
+
+            for(auto it = LowerBound(from); it != end() && compare_(it->first, to); ++it)
+            {
+                function(*it);
+            }
+        }
+
+        // Вызывает function для всех элементов по возрастанию ключей
+        template <typename Function>
+        void ForEach(Function function) const
+        {
+            EpochReclamation::Guard guard;
+
+            for(const value_type& entry : *this)
+            {
+                function(entry);
+            }
+        }
+
+    private:
+        static constexpr std::uintptr_t kMark = 1;
+        // При вероятности 1/4 перехода на следующий уровень хватает для 4^(kMaxHeight - 1) элементов
+        static constexpr size_t kMaxHeight = 16;
+
+        static constexpr size_t RoundUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        static constexpr size_t kTowerOffset = RoundUp(sizeof(Node), alignof(Link));
+
+        static constexpr size_t NodeSize(size_t height)
+        {
+            return kTowerOffset + height * sizeof(Link);
+        }
+
+        template <size_t Height>
+        static void* AllocateHeight()
+        {
+            using Arena = NodeArena<NodeSize(Height), alignof(Node)>;
+
+            if constexpr(Arena::kSupported)
+            {
+                return Arena::Instance().Allocate();
+            }
+            else
+            {
+                return ::operator new(NodeSize(Height));
+            }
+        }
+
+        template <size_t Height>
+        static void DeallocateHeight(void* pointer) noexcept
+        {
+            using Arena = NodeArena<NodeSize(Height), alignof(Node)>;
+
+            if constexpr(Arena::kSupported)
+            {
+                Arena::Instance().Deallocate(pointer);
+            }
+            else
+            {
+                ::operator delete(pointer);
+            }
+        }
+
+        // Узлы каждой высоты выделяются распределителем своего размера
+        template <size_t... Indices>
+        static void* Allocate(size_t height, std::index_sequence<Indices...>)
+        {
+            static constexpr void* (*kAllocators[])() = {&AllocateHeight<Indices + 1>...};
+
+            return kAllocators[height - 1]();
+        }
+
+        template <size_t... Indices>
+        static void Deallocate(void* pointer, size_t height, std::index_sequence<Indices...>) noexcept
+        {
+            static constexpr void (*kDeallocators[])(void*) noexcept = {&DeallocateHeight<Indices + 1>...};
+
+            kDeallocators[height - 1](pointer);
+        }
+
+        static Node* Create(Key key, Value value, size_t height)
+        {
+            void* memory = Allocate(height, std::make_index_sequence<kMaxHeight>());
+            Node* node;
+
+            try
+            {
+                node = new(memory) Node(std::move(key), std::move(value), height);
+            }
+            catch(...)
+            {
+                Deallocate(memory, height, std::make_index_sequence<kMaxHeight>());
+                throw;
+            }
+
+            for(size_t level = 0; level < height; ++level)
+            {
+                new(&node->Tower()[level]) Link(0);
+            }
+
+            return node;
+        }
+
+        static void Destroy(Node* node) noexcept
+        {
+            const size_t height = node->height;
+            node->~Node();
+            Deallocate(node, height, std::make_index_sequence<kMaxHeight>());
+        }
+
+        static Node* Pointer(std::uintptr_t link) noexcept
+        {
+            return reinterpret_cast<Node*>(link & ~kMark);
+        }
+
+        // Первый узел, начиная с node, нижний уровень которого не помечен
+        static Node* SkipMarked(Node* node) noexcept
+        {
+            while(node != nullptr)
+            {
+                const std::uintptr_t next = node->Tower()[0].load(std::memory_order_acquire);
+
+                if((next & kMark) == 0)
+                {
+                    break;
+                }
+
+                node = Pointer(next);
+            }
+
+            return node;
+        }
+
+        // Высота башни нового узла: каждый следующий уровень с вероятностью 1/4
+        static size_t RandomHeight() noexcept
+        {
+            static thread_local std::uint64_t state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            const size_t height = 1 + static_cast<size_t>(__builtin_ctzll(state | std::uint64_t{1} << 62)) / 2;
+
+            return height < kMaxHeight ? height : kMaxHeight;
+        }
+
+        /*
+         * Находит на каждом уровне ссылку preds[level] на первый узел succs[level] с ключом не меньше key
+         * Попутно исключает помеченные узлы. Возвращает true, если на нижнем уровне найден узел с ключом key
+         */
+        bool Find(const Key& key, Link** preds, Node** succs)
+        {
+            retry:
+            Link* pred = head_;
+
+            for(size_t level = kMaxHeight; level-- > 0; )
+            {
+                Node* current = Pointer(pred[level].load());
+
+                while(current != nullptr)
+                {
+                    std::uintptr_t next = current->Tower()[level].load();
+
+                    if((next & kMark) != 0)
+                    {
+                        std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(current);
+
+                        if(!pred[level].compare_exchange_strong(expected, next & ~kMark))
+                        {
+                            goto retry;
+                        }
+
+                        current = Pointer(next);
+
+                        continue;
+                    }
+
+                    if(!compare_(current->entry.first, key))
+                    {
+                        break;
+                    }
+
+                    pred = current->Tower();
+                    current = Pointer(next);
+                }
+
+                preds[level] = pred;
+                succs[level] = current;
+            }
+
+            return succs[0] != nullptr && !compare_(key, succs[0]->entry.first);
+        }
+
+        // Поиск только для чтения: помеченные узлы пропускаются, а не исключаются
+        Node* LowerBoundNode(const Key& key) const
+        {
+            const Link* pred = head_;
+            Node* current = nullptr;
+
+            for(size_t level = kMaxHeight; level-- > 0; )
+            {
+                current = Pointer(pred[level].load(std::memory_order_acquire));
+
+                while(current != nullptr)
+                {
+                    const std::uintptr_t next = current->Tower()[level].load(std::memory_order_acquire);
+
+                    if((next & kMark) == 0)
+                    {
+                        if(!compare_(current->entry.first, key))
+                        {
+                            break;
+                        }
+
+                        pred = current->Tower();
+                    }
+
+                    current = Pointer(next);
+                }
+            }
+
+            return current;
+        }
+
+        // Связывает верхние уровни вставленного узла; останавливается, если узел уже удаляют
+        void LinkUpperLevels(Node* node, Link** preds, Node** succs)
+        {
+            for(size_t level = 1; level < node->height; ++level)
+            {
+                while(true)
+                {
+                    // Ссылка узла меняется на новую, только если удаляющий поток её ещё не пометил
+                    std::uintptr_t next = node->Tower()[level].load(std::memory_order_acquire);
+                    const std::uintptr_t succ = reinterpret_cast<std::uintptr_t>(succs[level]);
+
+                    if((next & kMark) != 0
+                       || (next != succ && !node->Tower()[level].compare_exchange_strong(next, succ, std::memory_order_acq_rel,
+                                                                                         std::memory_order_relaxed)))
+                    {
+                        Finish(node);
+
+                        return;
+                    }
+
+                    std::uintptr_t expected = succ;
+
+                    if(preds[level][level].compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node)))
+                    {
+                        break;
+                    }
+
+                    if(!Find(node->entry.first, preds, succs) || succs[0] != node)
+                    {
+                        Finish(node);
+
+                        return;
+                    }
+                }
+            }
+
+            Finish(node);
+        }
+
+        /*
+         * Вызывается вставляющим потоком, закончившим связывать уровни, и удаляющим потоком
+         * после исключения узла. Второй из них отдаёт узел на освобождение
+         * Если узел удалён, пока вставляющий поток связывал верхние уровни, тот исключает их сам
+         * Связывание уровня, пометка и их проверки последовательно согласованы: вставляющий поток либо
+         * увидит пометку после своего последнего связывания, либо поиск удаляющего потока увидит это связывание
+         */
+        void Finish(Node* node)
+        {
+            if((node->Tower()[0].load() & kMark) != 0)
+            {
+                Link* preds[kMaxHeight];
+                Node* succs[kMaxHeight];
+                Find(node->entry.first, preds, succs);
+            }
+
+            if(node->done.fetch_add(1, std::memory_order_acq_rel) == 1)
+            {
+                EpochReclamation::Instance().Retire(node, [](void* pointer)
+                {
+                    Destroy(static_cast<Node*>(pointer));
+                });
+            }
+        }
+
+        Compare compare_;
+        // Башня фиктивного начального узла максимальной высоты
+        Link head_[kMaxHeight] = {};
+        std::atomic<size_t> size_{0};
+};
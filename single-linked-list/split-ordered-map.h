@@ -0,0 +1,490 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "epoch-reclamation.h"
+#include "node-arena.h"
+
+namespace split_ordered_detail
+{
+    static_assert(sizeof(size_t) * CHAR_BIT == 64, "split ordering expects 64-bit hashes");
+
+    inline size_t ReverseBits(size_t value) noexcept
+    {
+        value = (value >> 1 & 0x5555555555555555) | (value & 0x5555555555555555) << 1;
+        value = (value >> 2 & 0x3333333333333333) | (value & 0x3333333333333333) << 2;
+        value = (value >> 4 & 0x0F0F0F0F0F0F0F0F) | (value & 0x0F0F0F0F0F0F0F0F) << 4;
+        value = (value >> 8 & 0x00FF00FF00FF00FF) | (value & 0x00FF00FF00FF00FF) << 8;
+        value = (value >> 16 & 0x0000FFFF0000FFFF) | (value & 0x0000FFFF0000FFFF) << 16;
+
+        return value >> 32 | value << 32;
+    }
+}
+
+/*
+ * Параллельная хеш-таблица на упорядоченном по разделению списке (split-ordered list)
+ * Все элементы лежат в одном односвязном списке, упорядоченном по хешу с обращённым порядком бит.
+ * Тогда элементы корзины b таблицы из 2^k корзин идут в списке подряд, а при удвоении таблицы
+ * корзина b делится на b и b + 2^k без перемещения узлов: новая корзина — лишь ссылка на новый
+ * фиктивный узел внутри того же списка. Корзины создаются лениво, при первом обращении, а массив
+ * корзин растёт сегментами, которые тоже не перемещаются
+ * Список — список Харриса — Майкла: удаляемый узел сначала помечается битом в своём указателе
+ * next, затем исключается из списка; исключённые узлы освобождаются через EpochReclamation
+ * Сам список меняется только через CAS и блокировок не берёт
+ * Узлы выделяются из распределителя NodeArena, как и узлы SingleLinkedList, — обычно из кеша потока
+ * без блокировок. Когда кеш пуст или полон, распределитель ненадолго берёт свою блокировку. Выделить
+ * или освободить узел может любая операция (корзины создаются при первом обращении, а исключённые узлы
+ * освобождает исключивший их поток, когда их накопится достаточно), поэтому, как и при выделении через malloc,
+ * таблица в целом не свободна от блокировок в строгом смысле
+ * Все методы можно вызывать из любых потоков одновременно, кроме конструктора и деструктора
+ * Значения не меняются после вставки; Find возвращает их копию
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class SplitOrderedMap
+{
+    // Узел списка. Фиктивные узлы корзин имеют чётный ключ порядка, узлы элементов — нечётный
+    struct Node
+    {
+        explicit Node(size_t key) noexcept : order_key(key) {}
+
+        // Указатель на следующий узел; младший бит помечает этот узел как удаляемый
+        std::atomic<std::uintptr_t> next{0};
+        const size_t order_key;
+    };
+
+    struct Entry : Node
+    {
+        Entry(size_t order_key, Key entry_key, Value entry_value)
+            : Node(order_key), key(std::move(entry_key)), value(std::move(entry_value))
+        {
+        }
+
+        static void* operator new(size_t size)
+        {
+            assert(size == sizeof(Entry));
+
+            return Allocate<Entry>();
+        }
+
+        static void operator delete(void* pointer) noexcept
+        {
+            Deallocate<Entry>(pointer);
+        }
+
+        const Key key;
+        const Value value;
+    };
+
+    struct Dummy : Node
+    {
+        using Node::Node;
+
+        static void* operator new(size_t size)
+        {
+            assert(size == sizeof(Dummy));
+
+            return Allocate<Dummy>();
+        }
+
+        static void operator delete(void* pointer) noexcept
+        {
+            Deallocate<Dummy>(pointer);
+        }
+    };
+
+    public:
+        explicit SplitOrderedMap(Hash hash = Hash(), KeyEqual key_equal = KeyEqual())
+            : hash_(std::move(hash)), key_equal_(std::move(key_equal))
+        {
+            segments_[0] = new std::atomic<Dummy*>[1]();
+            segments_[0][0].store(new Dummy(0), std::memory_order_relaxed);
+        }
+
+        SplitOrderedMap(const SplitOrderedMap&) = delete;
+        SplitOrderedMap& operator=(const SplitOrderedMap&) = delete;
+
+        // Вызывается, когда таблицу больше не используют другие потоки
+        ~SplitOrderedMap()
+        {
+            Node* node = segments_[0][0].load(std::memory_order_relaxed);
+
+            while(node != nullptr)
+            {
+                Node* next = Pointer(node->next.load(std::memory_order_relaxed));
+                Delete(node);
+                node = next;
+            }
+
+            for(auto& segment : segments_)
+            {
+                delete[] segment.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Вставляет элемент, если элемента с таким ключом нет. Возвращает true, если вставил
+        bool Insert(Key key, Value value)
+        {
+            EpochReclamation::Guard guard;
+            const size_t hash = hash_(key);
+            const size_t order_key = RegularKey(hash);
+            Dummy* bucket = GetBucket(hash & (bucket_count_.load(std::memory_order_acquire) - 1));
+            Entry* entry = nullptr;
+
+            while(true)
+            {
+                Position position;
+
+                // После первой попытки ключ уже перемещён в новый узел
+                if(FindPosition(bucket, order_key, entry != nullptr ? &entry->key : &key, position))
+                {
+                    delete entry;
+
+                    return false;
+                }
+
+                if(entry == nullptr)
+                {
+                    entry = new Entry(order_key, std::move(key), std::move(value));
+                }
+
+                entry->next.store(reinterpret_cast<std::uintptr_t>(position.current), std::memory_order_relaxed);
+                std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(position.current);
+
+                if(position.link->compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(entry),
+                                                          std::memory_order_release, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+
+            Grow(size_.fetch_add(1, std::memory_order_relaxed) + 1);
+
+            return true;
+        }
+
+        // Удаляет элемент с ключом key. Возвращает true, если удалил
+        bool Erase(const Key& key)
+        {
+            EpochReclamation::Guard guard;
+            const size_t hash = hash_(key);
+            const size_t order_key = RegularKey(hash);
+            Dummy* bucket = GetBucket(hash & (bucket_count_.load(std::memory_order_acquire) - 1));
+
+            while(true)
+            {
+                Position position;
+
+                if(!FindPosition(bucket, order_key, &key, position))
+                {
+                    return false;
+                }
+
+                // Пометка указателя next делает удаление видимым; удаляет тот поток, чья пометка успешна
+                std::uintptr_t next = position.current->next.load(std::memory_order_acquire);
+
+                if((next & kMark) != 0
+                   || !position.current->next.compare_exchange_strong(next, next | kMark, std::memory_order_acq_rel,
+                                                                      std::memory_order_relaxed))
+                {
+                    continue;
+                }
+
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(position.current);
+
+                if(position.link->compare_exchange_strong(expected, next, std::memory_order_release,
+                                                          std::memory_order_relaxed))
+                {
+                    Retire(position.current);
+                }
+                else
+                {
+                    // Помеченный узел исключит из списка следующий обход
+                    FindPosition(bucket, order_key, &key, position);
+                }
+
+                return true;
+            }
+        }
+
+        // Возвращает копию значения элемента с ключом key либо std::nullopt
+        [[nodiscard]] std::optional<Value> Find(const Key& key)
+        {
+            EpochReclamation::Guard guard;
+            const size_t hash = hash_(key);
+            Dummy* bucket = GetBucket(hash & (bucket_count_.load(std::memory_order_acquire) - 1));
+            Position position;
+
+            if(!FindPosition(bucket, RegularKey(hash), &key, position))
+            {
+                return std::nullopt;
+            }
+
+            return static_cast<Entry*>(position.current)->value;
+        }
+
+        [[nodiscard]] bool Contains(const Key& key)
+        {
+            return Find(key).has_value();
+        }
+
+        // Число элементов; при одновременных изменениях — приблизительное
+        [[nodiscard]] size_t GetSize() const noexcept
+        {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t GetBucketCount() const noexcept
+        {
+            return bucket_count_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // Место в списке: ссылка link на узел current, первый узел с ключом порядка не меньше искомого
+        struct Position
+        {
+            std::atomic<std::uintptr_t>* link = nullptr;
+            Node* current = nullptr;
+        };
+
+        static constexpr std::uintptr_t kMark = 1;
+        static constexpr size_t kMaxLoadFactor = 2;
+        // Сегмент s > 0 содержит корзины [2^(s-1), 2^s), сегмент 0 — корзину 0
+        static constexpr size_t kSegmentCount = 48;
+
+        template <typename NodeType>
+        static void* Allocate()
+        {
+            using Arena = NodeArena<sizeof(NodeType), alignof(NodeType)>;
+
+            if constexpr(Arena::kSupported)
+            {
+                return Arena::Instance().Allocate();
+            }
+            else
+            {
+                return ::operator new(sizeof(NodeType));
+            }
+        }
+
+        template <typename NodeType>
+        static void Deallocate(void* pointer) noexcept
+        {
+            using Arena = NodeArena<sizeof(NodeType), alignof(NodeType)>;
+
+            if constexpr(Arena::kSupported)
+            {
+                Arena::Instance().Deallocate(pointer);
+            }
+            else
+            {
+                ::operator delete(pointer);
+            }
+        }
+
+        static Node* Pointer(std::uintptr_t link) noexcept
+        {
+            return reinterpret_cast<Node*>(link & ~kMark);
+        }
+
+        static bool IsDummy(const Node* node) noexcept
+        {
+            return (node->order_key & 1) == 0;
+        }
+
+        static void Delete(Node* node) noexcept
+        {
+            if(IsDummy(node))
+            {
+                delete static_cast<Dummy*>(node);
+            }
+            else
+            {
+                delete static_cast<Entry*>(node);
+            }
+        }
+
+        // Фиктивные узлы не удаляются, поэтому откладывается только освобождение элементов
+        static void Retire(Node* node)
+        {
+            EpochReclamation::Instance().Retire(static_cast<Entry*>(node), [](void* pointer)
+            {
+                delete static_cast<Entry*>(pointer);
+            });
+        }
+
+        // Ключ порядка элемента: старший бит хеша становится младшим и отличает элементы от корзин
+        static size_t RegularKey(size_t hash) noexcept
+        {
+            return split_ordered_detail::ReverseBits(hash | size_t{1} << 63);
+        }
+
+        static size_t DummyKey(size_t bucket) noexcept
+        {
+            return split_ordered_detail::ReverseBits(bucket);
+        }
+
+        /*
+         * Ищет от узла start первый узел с ключом порядка не меньше order_key и, для элементов,
+         * с ключом key. Попутно исключает из списка помеченные узлы
+         * Возвращает true, если найден элемент с ключом key (или фиктивный узел при key == nullptr)
+         */
+        bool FindPosition(Node* start, size_t order_key, const Key* key, Position& position)
+        {
+            retry:
+            position.link = &start->next;
+            position.current = Pointer(position.link->load(std::memory_order_acquire));
+
+            while(position.current != nullptr)
+            {
+                Node* current = position.current;
+                const std::uintptr_t next = current->next.load(std::memory_order_acquire);
+
+                // Ссылка на current могла измениться или её узел — оказаться помеченным
+                if(position.link->load(std::memory_order_acquire) != reinterpret_cast<std::uintptr_t>(current))
+                {
+                    goto retry;
+                }
+
+                if((next & kMark) != 0)
+                {
+                    std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(current);
+
+                    if(!position.link->compare_exchange_strong(expected, next & ~kMark, std::memory_order_acq_rel,
+                                                               std::memory_order_relaxed))
+                    {
+                        goto retry;
+                    }
+
+                    Retire(current);
+                    position.current = Pointer(next);
+
+                    continue;
+                }
+
+                if(current->order_key > order_key)
+                {
+                    return false;
+                }
+
+                if(current->order_key == order_key
+                   && (key == nullptr || (!IsDummy(current) && key_equal_(static_cast<Entry*>(current)->key, *key))))
+                {
+                    return true;
+                }
+
+                position.link = &current->next;
+                position.current = Pointer(next);
+            }
+
+            return false;
+        }
+
+        static size_t SegmentOf(size_t bucket) noexcept
+        {
+            return bucket == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(bucket));
+        }
+
+        static size_t SegmentStart(size_t segment) noexcept
+        {
+            return segment == 0 ? 0 : size_t{1} << (segment - 1);
+        }
+
+        std::atomic<Dummy*>& BucketSlot(size_t bucket)
+        {
+            const size_t segment = SegmentOf(bucket);
+            std::atomic<Dummy*>* slots = segments_[segment].load(std::memory_order_acquire);
+
+            if(slots == nullptr)
+            {
+                auto* created = new std::atomic<Dummy*>[SegmentStart(segment) == 0 ? 1 : SegmentStart(segment)]();
+
+                if(segments_[segment].compare_exchange_strong(slots, created, std::memory_order_acq_rel))
+                {
+                    slots = created;
+                }
+                else
+                {
+                    delete[] created;
+                }
+            }
+
+            return slots[bucket - SegmentStart(segment)];
+        }
+
+        // Фиктивный узел корзины; при первом обращении вставляется в список после узла родительской корзины
+        Dummy* GetBucket(size_t bucket)
+        {
+            std::atomic<Dummy*>& slot = BucketSlot(bucket);
+            Dummy* dummy = slot.load(std::memory_order_acquire);
+
+            if(dummy != nullptr)
+            {
+                return dummy;
+            }
+
+            // Родительская корзина — корзина без старшего единичного бита номера
+            Dummy* parent = GetBucket(bucket & ~(size_t{1} << (SegmentOf(bucket) - 1)));
+            const size_t order_key = DummyKey(bucket);
+            Dummy* created = nullptr;
+
+            while(true)
+            {
+                Position position;
+
+                if(FindPosition(parent, order_key, nullptr, position))
+                {
+                    // Корзину уже вставил другой поток
+                    delete created;
+                    dummy = static_cast<Dummy*>(position.current);
+
+                    break;
+                }
+
+                if(created == nullptr)
+                {
+                    created = new Dummy(order_key);
+                }
+
+                created->next.store(reinterpret_cast<std::uintptr_t>(position.current), std::memory_order_relaxed);
+                std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(position.current);
+
+                if(position.link->compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(created),
+                                                          std::memory_order_release, std::memory_order_relaxed))
+                {
+                    dummy = created;
+
+                    break;
+                }
+            }
+
+            slot.store(dummy, std::memory_order_release);
+
+            return dummy;
+        }
+
+        // Удваивает число корзин, если средняя длина корзины превысила kMaxLoadFactor
+        void Grow(size_t size) noexcept
+        {
+            size_t bucket_count = bucket_count_.load(std::memory_order_relaxed);
+
+            if(size > bucket_count * kMaxLoadFactor && bucket_count < SegmentStart(kSegmentCount - 1))
+            {
+                bucket_count_.compare_exchange_strong(bucket_count, bucket_count * 2, std::memory_order_release,
+                                                      std::memory_order_relaxed);
+            }
+        }
+
+        Hash hash_;
+        KeyEqual key_equal_;
+        std::atomic<std::atomic<Dummy*>*> segments_[kSegmentCount] = {};
+        std::atomic<size_t> bucket_count_{2};
+        std::atomic<size_t> size_{0};
+};
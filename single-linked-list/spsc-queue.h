@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+#include "single-linked-list.h"
+
+/*
+ * Очередь одного производителя и одного потребителя (SPSC) на узлах SingleLinkedList без блокировок
+ * Узлы образуют одну цепочку: first_ -> ... -> head_ -> ... -> tail_
+ * head_ — фиктивный узел (stub), значение которого уже забрано; элементы очереди лежат после него
+ * Узлы от first_ до head_ потребитель уже освободил, и производитель берёт их для новых элементов
+ * вместо выделения памяти. Каждый узел, кроме head_, принадлежит ровно одной стороне, поэтому общими
+ * являются только указатель next_node последнего узла и head_. Производитель публикует узел записью
+ * next_node с release, потребитель читает его с acquire; так же потребитель публикует head_
+ * Push и TryPop завершаются за ограниченное число шагов независимо от другой стороны; ждать может
+ * только выделение нового узла, когда освобождённых узлов нет
+ * Push вызывается только из потока производителя, TryPop и IsEmpty — только из потока потребителя
+ * Тип элементов должен допускать конструирование по умолчанию (для фиктивного узла, как и в списке)
+ * и присваивание перемещением
+ */
+template <typename Type>
+class SpscQueue
+{
+    using Node = typename SingleLinkedList<Type>::Node;
+
+    public:
+        SpscQueue() : first_(new Node()), tail_(first_), free_end_(first_), head_(first_)
+        {
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Вызывается, когда ни производитель, ни потребитель очередь больше не используют
+        ~SpscQueue()
+        {
+            SingleLinkedList<Type>::DestroyChain(first_);
+        }
+
+        // Добавляет элемент в конец очереди. Исключение при выделении узла или присваивании очередь не меняет
+        void Push(Type value)
+        {
+            Node* node = TakeFreeNode();
+
+            if(node != nullptr)
+            {
+                // Узел отделяется от цепочки освобождённых только после успешного присваивания
+                node->value = std::move(value);
+                first_ = first_->next_node;
+                node->next_node = nullptr;
+            }
+            else
+            {
+                node = new Node(std::move(value), nullptr);
+            }
+
+            // Значение узла становится видимо потребителю вместе с указателем на узел
+            tail_->next_node.StoreRelease(node);
+            tail_ = node;
+        }
+
+        // Извлекает элемент из начала очереди; std::nullopt, если очередь пуста
+        [[nodiscard]] std::optional<Type> TryPop()
+        {
+            Node* head = head_.load(std::memory_order_relaxed);
+            Node* next = head->next_node.LoadAcquire();
+
+            if(next == nullptr)
+            {
+                return std::nullopt;
+            }
+
+            std::optional<Type> value(std::move(next->value));
+            // Узел next становится фиктивным, а прежний фиктивный узел переходит к производителю
+            head_.store(next, std::memory_order_release);
+
+            return value;
+        }
+
+        [[nodiscard]] bool IsEmpty() const noexcept
+        {
+            return head_.load(std::memory_order_relaxed)->next_node.LoadAcquire() == nullptr;
+        }
+
+    private:
+        // Первый освобождённый потребителем узел либо nullptr, если таких нет. Узел из цепочки не убирается
+        Node* TakeFreeNode() noexcept
+        {
+            if(first_ == free_end_)
+            {
+                // Прочитанная копия head_ позволяет не обращаться к общей строке кеша при каждой вставке
+                free_end_ = head_.load(std::memory_order_acquire);
+
+                if(first_ == free_end_)
+                {
+                    return nullptr;
+                }
+            }
+
+            return first_;
+        }
+
+        // Поля производителя
+        Node* first_;
+        Node* tail_;
+        // Копия head_: узлы от first_ до free_end_ освобождены потребителем
+        Node* free_end_;
+
+        // Поле потребителя, отделённое от полей производителя строкой кеша
+        alignas(64) std::atomic<Node*> head_;
+};